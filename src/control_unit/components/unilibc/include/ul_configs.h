@@ -24,6 +24,8 @@
 ************************************************************************************************************/
 
 // #define UL_CONFIG_PM_DOUBLE_BUFFER									// Comment to disable the classic PowerMonitor double sample buffer mode. Instead, the callback sample selection mode will be used.
+#define UL_CONFIG_PM_FIXED_POINT										// Comment to accumulate the samples on floats instead of int32/int64 (slower on FPU-less or single precision FPU targets).
+#define UL_CONFIG_PM_HARMONICS							7				// Comment to disable the harmonic analysis; otherwise, number of analyzed harmonics (fundamental included).
 
 /************************************************************************************************************
 * ul_master_slave.h
@@ -35,8 +37,21 @@
 * ul_crc.h
 ************************************************************************************************************/
 
+#define UL_CONFIG_CRC_TABLE_SIZE						256 	// Comment to compute the CRCs bit by bit; otherwise, lookup tables entries (256: fastest, 16: smallest).
+
 #define UL_CONFIG_CRC_CRC8_POLYNOMIAL				0x07		// Standard CRC8 configurations.
 #define UL_CONFIG_CRC8_INITIAL_VALUE				0x00
 #define UL_CONFIG_CRC_CRC8_FINAL_XOR_VALUE	0x00
+// #define UL_CONFIG_CRC_CRC8_REFLECTED								// Uncomment for reflected (LSB first) CRCs: the polynomial must be reversed too.
+
+#define UL_CONFIG_CRC_CRC16_POLYNOMIAL				0xA001		// CRC-16/MODBUS configurations; comment to disable the CRC-16.
+#define UL_CONFIG_CRC_CRC16_INITIAL_VALUE			0xFFFF
+#define UL_CONFIG_CRC_CRC16_FINAL_XOR_VALUE		0x0000
+#define UL_CONFIG_CRC_CRC16_REFLECTED
+
+#define UL_CONFIG_CRC_CRC32_POLYNOMIAL				0xEDB88320	// CRC-32 (ISO-HDLC) configurations; comment to disable the CRC-32.
+#define UL_CONFIG_CRC_CRC32_INITIAL_VALUE			0xFFFFFFFF
+#define UL_CONFIG_CRC_CRC32_FINAL_XOR_VALUE		0xFFFFFFFF
+#define UL_CONFIG_CRC_CRC32_REFLECTED
 
 #endif  /* INC_UL_CONFIGS_H_ */
@@ -71,8 +71,73 @@ typedef struct __attribute__((__packed__)) {
 	float p_var;
 	float p_pf;
 
+	// Mains frequency (0 if no mains cycle was detected or `ul_pm_init_t::sample_rate_hz` is 0).
+	float frequency_hz;
+
+	#ifdef UL_CONFIG_PM_HARMONICS
+
+	/**
+	 * Harmonics from the fundamental (index 0) to the `UL_CONFIG_PM_HARMONICS`-th:
+	 * RMS value and phase in degrees, relative to the voltage fundamental (`phase_k - k * v_phase_1`).
+	 */
+	float v_harmonics_rms[UL_CONFIG_PM_HARMONICS];
+	float v_harmonics_phase[UL_CONFIG_PM_HARMONICS];
+	float i_harmonics_rms[UL_CONFIG_PM_HARMONICS];
+	float i_harmonics_phase[UL_CONFIG_PM_HARMONICS];
+
+	// Total harmonic distortion relative to the fundamental (%).
+	float v_thd;
+	float i_thd;
+
+	#endif
+
 } ul_pm_results_t;
 
+// Single mains cycle results.
+typedef struct __attribute__((__packed__)) {
+
+	float frequency_hz;
+	float v_rms;
+	float i_rms;
+	float p_w;
+
+} ul_pm_cycle_results_t;
+
+// Results of a `ul_pm_aggregate_t`.
+typedef struct __attribute__((__packed__)) {
+
+	float v_rms;
+	float i_rms;
+
+	float p_va;
+	float p_w;
+	float p_var;
+	float p_pf;
+
+	// Mains frequency (0 if no mains cycle was detected).
+	float frequency_hz;
+
+} ul_pm_aggregate_results_t;
+
+// Results of an additional current channel (see `ul_pm_circuits_t`).
+typedef struct __attribute__((__packed__)) {
+
+	float i_rms;
+
+	float p_va;
+	float p_w;
+	float p_var;
+	float p_pf;
+
+} ul_pm_circuit_results_t;
+
+/**
+ * @brief Callback called at the end of every mains cycle detected while feeding the samples.
+ * @param user_context `ul_pm_init_t::cycle_callback_context`.
+ * @param res The results of the cycle just ended.
+ */
+typedef void (*ul_pm_cycle_callback_t)(void *user_context, ul_pm_cycle_results_t *res);
+
 // Instance configurations.
 typedef struct {
 
@@ -115,15 +180,168 @@ typedef struct {
 	// Set to 1 if unused.
 	float i_correction_factor;
 
+	/**
+	 * Sample rate of each channel, used to evaluate the mains frequency.
+	 * Set to 0 if unknown.
+	 */
+	float sample_rate_hz;
+
+	/**
+	 * Length of the `ul_pm_stream_*()` windows:
+	 * - If `cycles_per_window` is 0, every window is `window_samples` long.
+	 * - Otherwise, every window starts and ends on a rising zero-crossing of the voltage and covers
+	 *   exactly `cycles_per_window` mains cycles; `window_samples` is the upper bound used when no mains is detected.
+	 * If `window_samples` is 0, windows only end on the cycle count or when `ul_pm_stream_finalize()` is called.
+	 */
+	uint8_t cycles_per_window;
+	uint32_t window_samples;
+
+	// Optional callback for the per-cycle results; leave it to `NULL` if unused.
+	ul_pm_cycle_callback_t cycle_callback;
+	void *cycle_callback_context;
+
+	#ifdef UL_CONFIG_PM_HARMONICS
+
+	/**
+	 * Mains frequency used by the harmonic analysis until the first one is measured.
+	 * The harmonic analysis needs `sample_rate_hz` too.
+	 */
+	float nominal_frequency_hz;
+
+	#endif
+
 	#ifndef UL_CONFIG_PM_DOUBLE_BUFFER
 
-	// Callback to retrieve the samples needed for `ul_pm_evaluate()`.
+	/**
+	 * Callback to retrieve the samples needed for `ul_pm_evaluate()`.
+	 * Can be `NULL` if only the `*_span()` functions are used.
+	 */
 	ul_pm_sample_callback_t sample_callback;
 
 	#endif
 
 } ul_pm_init_t;
 
+/**
+ * Layout of a single channel inside a raw, interleaved sample buffer (e.g. an ADC DMA frame).
+ * Every sample is read as a little-endian 16-bit word at `offset_bytes + i * stride_bytes`,
+ * then extracted as `(word >> shift) & mask`.
+ */
+typedef struct {
+
+	// Position of the first sample of the channel.
+	uint16_t offset_bytes;
+
+	// Distance between two consecutive samples of the channel.
+	uint16_t stride_bytes;
+
+	// Bitfield extraction.
+	uint8_t shift;
+	uint16_t mask;
+
+} ul_pm_span_t;
+
+#ifdef UL_CONFIG_PM_FIXED_POINT
+
+/**
+ * Integer accumulators: 12-bit samples fit in `int32_t` sums and
+ * their squares/products in `int64_t` sums for any realistic window length.
+ */
+typedef int32_t ul_pm_sum_t;
+typedef int64_t ul_pm_quadratic_sum_t;
+
+#else
+
+typedef float ul_pm_sum_t;
+typedef float ul_pm_quadratic_sum_t;
+
+#endif
+
+/**
+ * Partial sums, relative to the DC offsets estimate to keep them small and numerically stable.
+ * The `k_v` and `k_i` scaling is only applied when they are evaluated.
+ */
+typedef struct {
+
+	// Number of accumulated samples per channel.
+	uint32_t samples_len;
+
+	// Sum of `(sample - offset)`.
+	ul_pm_sum_t v_sum, i_sum;
+
+	// Sum of `(sample - offset)^2`.
+	ul_pm_quadratic_sum_t v_quadratic_sum, i_quadratic_sum;
+
+	// Sum of `(v_sample - v_offset) * (i_sample - i_offset)`.
+	ul_pm_quadratic_sum_t instant_power_sum;
+
+} ul_pm_sums_t;
+
+// Streaming accumulator.
+typedef struct {
+
+	// Current window.
+	ul_pm_sums_t sums;
+
+	// DC offsets estimate (raw ADC values).
+	uint16_t v_offset, i_offset;
+
+	// Raw peaks.
+	uint16_t v_min, v_max;
+	uint16_t i_min, i_max;
+
+	/* Window limits (0 for no limit) */
+
+	uint32_t window_samples;
+	uint8_t window_cycles;
+
+	// The window is complete: no more samples are accepted until `ul_pm_stream_finalize()`.
+	bool window_ready;
+
+	// Samples dropped from the window by the last feed (see `ul_pm_init_t::cycles_per_window`).
+	uint32_t dropped_len;
+
+	/* Zero-crossing tracking on the voltage channel */
+
+	// Previous voltage sample, relative to `v_offset`.
+	int32_t v_prev;
+
+	// The voltage went under the hysteresis since the last rising zero-crossing.
+	bool zc_armed;
+
+	// `zc_last` holds a valid rising zero-crossing.
+	bool zc_locked;
+
+	// Interpolated position of the last rising zero-crossing, in samples from the start of the window (can be negative).
+	float zc_last;
+
+	// `sums` at the last rising zero-crossing: the per-cycle sums are the difference.
+	ul_pm_sums_t cycle_start;
+
+	// Complete mains cycles in the window and their total length in samples.
+	uint16_t cycles;
+	float cycles_len;
+
+	#ifdef UL_CONFIG_PM_HARMONICS
+
+	/* Goertzel filters bank, tuned on the mains cycle length measured on the previous window */
+
+	// Fundamental cycle length (samples) the filters are tuned on; 0 if unknown.
+	float harmonics_cycle_len;
+
+	// `2 * cos(w_k)`, `cos(w_k)` and `sin(w_k)` for every harmonic.
+	float harmonics_coef[UL_CONFIG_PM_HARMONICS];
+	float harmonics_cos[UL_CONFIG_PM_HARMONICS];
+	float harmonics_sin[UL_CONFIG_PM_HARMONICS];
+
+	// Filters state: `s[n-1]` and `s[n-2]`.
+	float v_harmonics_s1[UL_CONFIG_PM_HARMONICS], v_harmonics_s2[UL_CONFIG_PM_HARMONICS];
+	float i_harmonics_s1[UL_CONFIG_PM_HARMONICS], i_harmonics_s2[UL_CONFIG_PM_HARMONICS];
+
+	#endif
+
+} ul_pm_stream_t;
+
 // Instance handle.
 typedef struct {
 
@@ -136,8 +354,61 @@ typedef struct {
 	// Formulas constants.
 	float k_v, k_i;
 
+	// Zero-crossing hysteresis (raw ADC value), equal to `ul_pm_init_t::v_rms_threshold`.
+	int32_t zc_hysteresis;
+
+	// Current `ul_pm_stream_*()` window.
+	ul_pm_stream_t stream;
+
 } ul_pm_handle_t;
 
+/**
+ * Mergeable partial sums of any number of windows (e.g. 1s or 15 minutes), with the DC offset
+ * of every window removed: merging them gives the exact RMS and power of the whole period,
+ * without going over the samples again. Zero-initialize it before the first window.
+ */
+typedef struct {
+
+	// Number of samples per channel.
+	uint64_t samples_len;
+
+	// Sum of `(v - v_avg)^2`, `(i - i_avg)^2` and `(v - v_avg) * (i - i_avg)` (raw ADC units).
+	double v_quadratic_sum;
+	double i_quadratic_sum;
+	double instant_power_sum;
+
+	// Complete mains cycles and their total length in samples.
+	uint32_t cycles;
+	double cycles_len;
+
+} ul_pm_aggregate_t;
+
+/**
+ * Additional current channels (e.g. per-circuit sub-metering clamps) sharing the voltage channel,
+ * the clamp configurations and the windows of a `ul_pm_handle_t`.
+ * The partial sums are stored as a struct of arrays: one item per circuit.
+ */
+typedef struct {
+
+	// Instance the circuits follow.
+	ul_pm_handle_t *pm;
+
+	// Number of circuits.
+	uint8_t len;
+
+	// Voltage partial sums, relative to the `pm` DC offset estimate.
+	uint32_t samples_len;
+	ul_pm_sum_t v_sum;
+	ul_pm_quadratic_sum_t v_quadratic_sum;
+
+	// Current partial sums, relative to the DC offsets estimate of every circuit.
+	uint16_t *i_offset;
+	ul_pm_sum_t *i_sum;
+	ul_pm_quadratic_sum_t *i_quadratic_sum;
+	ul_pm_quadratic_sum_t *instant_power_sum;
+
+} ul_pm_circuits_t;
+
 /************************************************************************************************************
 * Public Variables Prototypes
 ************************************************************************************************************/
@@ -164,6 +435,7 @@ extern void ul_pm_end(ul_pm_handle_t *self);
  * @param i_samples AC current samples.
  * @param samples_len Number of samples acquired.
  * @param res Where to store the evaluated result.
+ * @note All the samples are evaluated, regardless of `ul_pm_init_t::cycles_per_window` and `ul_pm_init_t::window_samples`.
  */
 extern ul_err_t ul_pm_evaluate(ul_pm_handle_t *self, uint16_t *v_samples, uint16_t *i_samples, uint32_t samples_len, ul_pm_results_t *res);
 
@@ -174,9 +446,121 @@ extern ul_err_t ul_pm_evaluate(ul_pm_handle_t *self, uint16_t *v_samples, uint16
  * @param samples_len Number of samples acquired.
  * @param user_context A generic user context to be passed to the `ul_pm_sample_callback_t`; leave it to `NULL` if unused.
  * @param res Where to store the evaluated result.
+ * @note All the samples are evaluated, regardless of `ul_pm_init_t::cycles_per_window` and `ul_pm_init_t::window_samples`.
  */
 extern ul_err_t ul_pm_evaluate(ul_pm_handle_t *self, void *user_context, uint32_t samples_len, ul_pm_results_t *res);
 
 #endif
 
+/**
+ * @brief Start a new stream of samples; the DC offsets estimate is reset to mid-scale.
+ * @note Call `ul_pm_stream_feed()` with every new chunk of samples and `ul_pm_stream_finalize()`
+ * every time `ul_pm_stream_window_ready()` returns true.
+ */
+extern ul_err_t ul_pm_stream_begin(ul_pm_handle_t *self);
+
+#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+
+/**
+ * @brief Accumulate a chunk of samples into the current window in a single pass.
+ * @param v_samples AC voltage samples.
+ * @param i_samples AC current samples.
+ * @param samples_len Number of samples in the chunk.
+ * @param consumed_len Number of samples actually accumulated: it is less than `samples_len` if the window got complete;
+ * feed the remaining ones after `ul_pm_stream_finalize()`.
+ */
+extern ul_err_t ul_pm_stream_feed(ul_pm_handle_t *self, uint16_t *v_samples, uint16_t *i_samples, uint32_t samples_len, uint32_t *consumed_len);
+
+#else
+
+/**
+ * @brief Accumulate a chunk of samples into the current window in a single pass.
+ * @param user_context A generic user context to be passed to the `ul_pm_sample_callback_t`; leave it to `NULL` if unused.
+ * @param samples_len Number of samples in the chunk; the callback is called with indexes from 0 to `samples_len - 1`.
+ * @param consumed_len Number of samples actually accumulated: it is less than `samples_len` if the window got complete;
+ * feed the remaining ones after `ul_pm_stream_finalize()`.
+ */
+extern ul_err_t ul_pm_stream_feed(ul_pm_handle_t *self, void *user_context, uint32_t samples_len, uint32_t *consumed_len);
+
+#endif
+
+/**
+ * @brief Evaluate a raw interleaved buffer in place, without any per-sample callback or copy.
+ * @param buffer Raw sample buffer.
+ * @param v_span AC voltage samples layout inside `buffer`.
+ * @param i_span AC current samples layout inside `buffer`.
+ * @param samples_len Number of samples per channel.
+ * @param res Where to store the evaluated result.
+ * @note All the samples are evaluated, like `ul_pm_evaluate()`.
+ */
+extern ul_err_t ul_pm_evaluate_span(ul_pm_handle_t *self, const void *buffer, const ul_pm_span_t *v_span, const ul_pm_span_t *i_span, uint32_t samples_len, ul_pm_results_t *res);
+
+/**
+ * @brief Like `ul_pm_stream_feed()`, but reads the samples in place from a raw interleaved buffer.
+ * @param buffer Raw sample buffer.
+ * @param v_span AC voltage samples layout inside `buffer`.
+ * @param i_span AC current samples layout inside `buffer`.
+ * @param samples_len Number of samples per channel in the chunk.
+ * @param consumed_len Number of samples actually accumulated (see `ul_pm_stream_feed()`).
+ * @param dropped_len Number of samples dropped from the window on its first zero-crossing, counting the ones
+ * accumulated by the previous calls too; 0 if none (see `ul_pm_init_t::cycles_per_window`).
+ */
+extern ul_err_t ul_pm_stream_feed_span(ul_pm_handle_t *self, const void *buffer, const ul_pm_span_t *v_span, const ul_pm_span_t *i_span, uint32_t samples_len, uint32_t *consumed_len, uint32_t *dropped_len);
+
+/**
+ * @brief Check if the current window is complete (see `ul_pm_init_t::cycles_per_window`).
+ */
+extern bool ul_pm_stream_window_ready(ul_pm_handle_t *self);
+
+/**
+ * @brief Evaluate the current window and start the next one.
+ * @param res Where to store the evaluated result.
+ * @note The next window uses the DC offsets measured on this one.
+ */
+extern ul_err_t ul_pm_stream_finalize(ul_pm_handle_t *self, ul_pm_results_t *res);
+
+/**
+ * @brief Add the partial sums of the current window to `aggregate`.
+ * @note Call it when `ul_pm_stream_window_ready()` returns true, before `ul_pm_stream_finalize()`.
+ */
+extern ul_err_t ul_pm_stream_aggregate(ul_pm_handle_t *self, ul_pm_aggregate_t *aggregate);
+
+/**
+ * @brief Add the partial sums of `src` to `dst`.
+ */
+extern ul_err_t ul_pm_aggregate_merge(ul_pm_aggregate_t *dst, const ul_pm_aggregate_t *src);
+
+/**
+ * @brief Evaluate the partial sums of `aggregate`, with the same thresholds of `ul_pm_stream_finalize()`.
+ */
+extern ul_err_t ul_pm_aggregate_evaluate(ul_pm_handle_t *self, const ul_pm_aggregate_t *aggregate, ul_pm_aggregate_results_t *res);
+
+/**
+ * @brief Create the additional current channels of `pm`.
+ * @param circuits_len Number of circuits.
+ */
+extern ul_err_t ul_pm_circuits_begin(ul_pm_handle_t *pm, uint8_t circuits_len, ul_pm_circuits_t **returned_handle);
+
+/**
+ * @brief Free the allocated resources.
+ */
+extern void ul_pm_circuits_end(ul_pm_circuits_t *self);
+
+/**
+ * @brief Accumulate the same chunk of samples just accumulated by `ul_pm_stream_feed_span()`, in a single pass.
+ * @param v_samples AC voltage samples.
+ * @param i_samples AC current samples of the first circuit; the ones of the next circuit start `i_stride` samples later.
+ * @param samples_len The `consumed_len` returned by `ul_pm_stream_feed_span()`.
+ * @param dropped_len The `dropped_len` returned by `ul_pm_stream_feed_span()`.
+ * @note Call it after every `ul_pm_stream_feed_span()`, so the circuits windows follow the `pm` ones.
+ */
+extern ul_err_t ul_pm_circuits_feed(ul_pm_circuits_t *self, const uint16_t *v_samples, const uint16_t *i_samples, uint32_t i_stride, uint32_t samples_len, uint32_t dropped_len);
+
+/**
+ * @brief Evaluate the current window of every circuit and start the next one.
+ * @param res Array of `circuits_len` results.
+ * @note Call it when `ul_pm_stream_window_ready()` returns true, along with `ul_pm_stream_finalize()`.
+ */
+extern ul_err_t ul_pm_circuits_finalize(ul_pm_circuits_t *self, ul_pm_circuit_results_t *res);
+
 #endif  /* INC_UL_PM_H_ */
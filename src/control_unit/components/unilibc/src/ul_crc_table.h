@@ -0,0 +1,187 @@
+/** @file ul_crc_table.h
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	Private to `ul_crc.c`: compile time generation of a CRC lookup table.
+ * 												Included once per table, with the following parameters defined:
+ *
+ * 												- `__CRC_TABLE`: the table name.
+ * 												- `__CRC_TYPE`: the table entries type (`uint8_t`, `uint16_t` or `uint32_t`).
+ * 												- `__CRC_WIDTH`: the CRC width in bits (8, 16 or 32).
+ * 												- `__CRC_POLYNOMIAL`: the polynomial (already reversed if reflected).
+ * 												- `__CRC_REFLECTED`: 1 for reflected (LSB first) CRCs, 0 otherwise.
+ *
+ * 												The table has `UL_CONFIG_CRC_TABLE_SIZE` entries (256: one per byte, 16: one per nibble).
+ * 												Parameters are undefined at the end.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+/**
+ * Every entry is the XOR of the basis entries selected by its bits, since the CRC register update is linear.
+ *
+ * The basis is `__CRC_B1`...`__CRC_B8`: `__CRC_B<k>` is the register after `k` shifts of a single set bit
+ * (the MSB if not reflected, the LSB otherwise). Each shift is selected by `#if`, so `__CRC_B<k>` refers to
+ * `__CRC_B<k-1>` only once and the expansion stays linear.
+ */
+
+/************************************************************************************************************
+* Basis
+************************************************************************************************************/
+
+#if __CRC_WIDTH == 32
+#define __CRC_MASK	0xFFFFFFFF
+#else
+#define __CRC_MASK	((1UL << __CRC_WIDTH) - 1)
+#endif
+
+#if __CRC_REFLECTED
+#define __CRC_B0	1
+#else
+#define __CRC_B0	(1UL << (__CRC_WIDTH - 1))
+#endif
+
+/**
+ * `__crc_carry(b)`: the bit of the register `b` leaving it on the next shift.
+ * `__crc_shift(b, carry)`: the register `b` after one shift.
+ */
+#if __CRC_REFLECTED
+#define __crc_carry(b)					((b) & 1)
+#define __crc_shift(b, carry)		(((b) >> 1) ^ ((carry) ? __CRC_POLYNOMIAL : 0))
+#else
+#define __crc_carry(b)					(((b) >> (__CRC_WIDTH - 1)) & 1)
+#define __crc_shift(b, carry)		((((b) << 1) & __CRC_MASK) ^ ((carry) ? __CRC_POLYNOMIAL : 0))
+#endif
+
+#if __crc_carry(__CRC_B0)
+#define __CRC_B1	__crc_shift(__CRC_B0, 1)
+#else
+#define __CRC_B1	__crc_shift(__CRC_B0, 0)
+#endif
+
+#if __crc_carry(__CRC_B1)
+#define __CRC_B2	__crc_shift(__CRC_B1, 1)
+#else
+#define __CRC_B2	__crc_shift(__CRC_B1, 0)
+#endif
+
+#if __crc_carry(__CRC_B2)
+#define __CRC_B3	__crc_shift(__CRC_B2, 1)
+#else
+#define __CRC_B3	__crc_shift(__CRC_B2, 0)
+#endif
+
+#if __crc_carry(__CRC_B3)
+#define __CRC_B4	__crc_shift(__CRC_B3, 1)
+#else
+#define __CRC_B4	__crc_shift(__CRC_B3, 0)
+#endif
+
+#if __crc_carry(__CRC_B4)
+#define __CRC_B5	__crc_shift(__CRC_B4, 1)
+#else
+#define __CRC_B5	__crc_shift(__CRC_B4, 0)
+#endif
+
+#if __crc_carry(__CRC_B5)
+#define __CRC_B6	__crc_shift(__CRC_B5, 1)
+#else
+#define __CRC_B6	__crc_shift(__CRC_B5, 0)
+#endif
+
+#if __crc_carry(__CRC_B6)
+#define __CRC_B7	__crc_shift(__CRC_B6, 1)
+#else
+#define __CRC_B7	__crc_shift(__CRC_B6, 0)
+#endif
+
+#if __crc_carry(__CRC_B7)
+#define __CRC_B8	__crc_shift(__CRC_B7, 1)
+#else
+#define __CRC_B8	__crc_shift(__CRC_B7, 0)
+#endif
+
+/************************************************************************************************************
+* Entries
+************************************************************************************************************/
+
+#define __crc_bit(x, i, b)	((((x) >> (i)) & 1) ? (b) : 0)
+
+/**
+ * Not reflected: the entry `x` is the register after shifting `x` out from its top bits.
+ * Reflected: the entry `x` is the register after shifting `x` out from its bottom bits.
+ */
+#if UL_CONFIG_CRC_TABLE_SIZE == 256 && __CRC_REFLECTED
+#define __crc_entry(x)( \
+	__crc_bit(x, 0, __CRC_B8) ^ __crc_bit(x, 1, __CRC_B7) ^ __crc_bit(x, 2, __CRC_B6) ^ __crc_bit(x, 3, __CRC_B5) ^ \
+	__crc_bit(x, 4, __CRC_B4) ^ __crc_bit(x, 5, __CRC_B3) ^ __crc_bit(x, 6, __CRC_B2) ^ __crc_bit(x, 7, __CRC_B1) \
+)
+
+#elif UL_CONFIG_CRC_TABLE_SIZE == 256
+#define __crc_entry(x)( \
+	__crc_bit(x, 0, __CRC_B1) ^ __crc_bit(x, 1, __CRC_B2) ^ __crc_bit(x, 2, __CRC_B3) ^ __crc_bit(x, 3, __CRC_B4) ^ \
+	__crc_bit(x, 4, __CRC_B5) ^ __crc_bit(x, 5, __CRC_B6) ^ __crc_bit(x, 6, __CRC_B7) ^ __crc_bit(x, 7, __CRC_B8) \
+)
+
+#elif UL_CONFIG_CRC_TABLE_SIZE == 16 && __CRC_REFLECTED
+#define __crc_entry(x)( \
+	__crc_bit(x, 0, __CRC_B4) ^ __crc_bit(x, 1, __CRC_B3) ^ __crc_bit(x, 2, __CRC_B2) ^ __crc_bit(x, 3, __CRC_B1) \
+)
+
+#elif UL_CONFIG_CRC_TABLE_SIZE == 16
+#define __crc_entry(x)( \
+	__crc_bit(x, 0, __CRC_B1) ^ __crc_bit(x, 1, __CRC_B2) ^ __crc_bit(x, 2, __CRC_B3) ^ __crc_bit(x, 3, __CRC_B4) \
+)
+
+#else
+#error "UL_CONFIG_CRC_TABLE_SIZE must be 256 or 16"
+#endif
+
+#define __crc_entries4(x)		(__CRC_TYPE) __crc_entry(x), (__CRC_TYPE) __crc_entry((x) + 1), (__CRC_TYPE) __crc_entry((x) + 2), (__CRC_TYPE) __crc_entry((x) + 3)
+#define __crc_entries16(x)	__crc_entries4(x), __crc_entries4((x) + 4), __crc_entries4((x) + 8), __crc_entries4((x) + 12)
+#define __crc_entries64(x)	__crc_entries16(x), __crc_entries16((x) + 16), __crc_entries16((x) + 32), __crc_entries16((x) + 48)
+#define __crc_entries256(x)	__crc_entries64(x), __crc_entries64((x) + 64), __crc_entries64((x) + 128), __crc_entries64((x) + 192)
+
+/************************************************************************************************************
+* Table
+************************************************************************************************************/
+
+static const __CRC_TYPE __CRC_TABLE[UL_CONFIG_CRC_TABLE_SIZE] __crc_table_attr = {
+	#if UL_CONFIG_CRC_TABLE_SIZE == 256
+	__crc_entries256(0)
+	#else
+	__crc_entries16(0)
+	#endif
+};
+
+/************************************************************************************************************
+* Cleanup
+************************************************************************************************************/
+
+#undef __crc_entries256
+#undef __crc_entries64
+#undef __crc_entries16
+#undef __crc_entries4
+#undef __crc_entry
+#undef __crc_bit
+#undef __crc_shift
+#undef __crc_carry
+
+#undef __CRC_B8
+#undef __CRC_B7
+#undef __CRC_B6
+#undef __CRC_B5
+#undef __CRC_B4
+#undef __CRC_B3
+#undef __CRC_B2
+#undef __CRC_B1
+#undef __CRC_B0
+#undef __CRC_MASK
+
+#undef __CRC_REFLECTED
+#undef __CRC_POLYNOMIAL
+#undef __CRC_WIDTH
+#undef __CRC_TYPE
+#undef __CRC_TABLE
@@ -18,6 +18,14 @@
 * Private Defines
 ************************************************************************************************************/
 
+// 7 bytes are exactly 8 encoded bytes.
+#define MS_GROUP_DECODED_SIZE	7
+#define MS_GROUP_ENCODED_SIZE	8
+
+// Wall terminals payload (see `rs485.c`).
+#define MS_PAYLOAD_3_SIZE					3
+#define MS_PAYLOAD_3_ENCODED_SIZE	4
+
 /************************************************************************************************************
 * Private Types Definitions
  ************************************************************************************************************/
@@ -30,6 +38,23 @@
 * Private Functions Prototypes
  ************************************************************************************************************/
 
+/**
+ * @brief Encode 7 bytes into 8: the encoded byte `k` holds the bits `7k...7k+6` of the group (LSb first).
+ * @param msb `0x80` for the master, `0x00` for the slaves.
+ */
+static inline void __encode_group(uint8_t *dest_buf, const uint8_t *src_buf, uint8_t msb);
+
+/**
+ * @brief Decode 8 bytes into 7, the inverse of `__encode_group()`.
+ */
+static inline void __decode_group(uint8_t *dest_buf, const uint8_t *src_buf);
+
+/**
+ * @brief Fixed size fast paths for the 3 bytes payload: the 24 bits fit in a single word.
+ */
+static inline void __encode_payload_3(uint8_t *dest_buf, const uint8_t *src_buf, uint8_t msb);
+static inline void __decode_payload_3(uint8_t *dest_buf, const uint8_t *src_buf);
+
 static ul_err_t __encode_message(uint8_t *dest_buf, uint8_t *src_buf, UL_MS_BUF_SIZE_T src_buf_size, bool master);
 static ul_err_t __decode_message(uint8_t *dest_buf, uint8_t *src_buf, UL_MS_BUF_SIZE_T src_buf_size, bool master);
 
@@ -37,32 +62,85 @@ static ul_err_t __decode_message(uint8_t *dest_buf, uint8_t *src_buf, UL_MS_BUF_
 * Private Functions Definitions
  ************************************************************************************************************/
 
+void __encode_group(uint8_t *dest_buf, const uint8_t *src_buf, uint8_t msb){
+	dest_buf[0] = (src_buf[0] & 0x7F) | msb;
+
+	// The encoded byte `k` takes the top `k` bits of the byte `k-1` and the bottom `7-k` bits of the byte `k`.
+	for(uint8_t k=1; k<MS_GROUP_DECODED_SIZE; k++)
+		dest_buf[k] = ((src_buf[k - 1] >> (8 - k) | src_buf[k] << k) & 0x7F) | msb;
+
+	dest_buf[7] = (src_buf[6] >> 1) | msb;
+}
+
+void __decode_group(uint8_t *dest_buf, const uint8_t *src_buf){
+
+	// The byte `k` takes the top `7-k` bits of the encoded byte `k` and the bottom `k+1` bits of the encoded byte `k+1`.
+	for(uint8_t k=0; k<MS_GROUP_DECODED_SIZE; k++)
+		dest_buf[k] = (src_buf[k] & 0x7F) >> k | src_buf[k + 1] << (7 - k);
+}
+
+void __encode_payload_3(uint8_t *dest_buf, const uint8_t *src_buf, uint8_t msb){
+	uint32_t word = (
+		(uint32_t) src_buf[0] |
+		(uint32_t) src_buf[1] << 8 |
+		(uint32_t) src_buf[2] << 16
+	);
+
+	dest_buf[0] = (word & 0x7F) | msb;
+	dest_buf[1] = ((word >> 7) & 0x7F) | msb;
+	dest_buf[2] = ((word >> 14) & 0x7F) | msb;
+	dest_buf[3] = (word >> 21) | msb;
+}
+
+void __decode_payload_3(uint8_t *dest_buf, const uint8_t *src_buf){
+	uint32_t word = (
+		(uint32_t) (src_buf[0] & 0x7F) |
+		(uint32_t) (src_buf[1] & 0x7F) << 7 |
+		(uint32_t) (src_buf[2] & 0x7F) << 14 |
+		(uint32_t) (src_buf[3] & 0x7F) << 21
+	);
+
+	dest_buf[0] = word;
+	dest_buf[1] = word >> 8;
+	dest_buf[2] = word >> 16;
+}
+
 ul_err_t __encode_message(uint8_t *dest_buf, uint8_t *src_buf, UL_MS_BUF_SIZE_T src_buf_size, bool master){
 	assert_param_notnull(dest_buf);
 	assert_param_notnull(src_buf);
 	assert_param_size_ok(src_buf_size);
 
-	uint32_t bit_index = 0;
-	uint8_t encoded_byte, j;
-	UL_MS_BUF_SIZE_T i, dest_buf_size = ul_ms_compute_encoded_size(src_buf_size);
+	uint8_t msb = (master ? 0x80 : 0x00);
+
+	if(src_buf_size == MS_PAYLOAD_3_SIZE){
+		__encode_payload_3(dest_buf, src_buf, msb);
+		return UL_OK;
+	}
 
-	memset(dest_buf, 0, dest_buf_size);
+	for(; src_buf_size >= MS_GROUP_DECODED_SIZE; src_buf_size -= MS_GROUP_DECODED_SIZE){
+		__encode_group(dest_buf, src_buf, msb);
 
-	for(i=0; i<dest_buf_size; i++){
-		encoded_byte = 0;
+		src_buf += MS_GROUP_DECODED_SIZE;
+		dest_buf += MS_GROUP_ENCODED_SIZE;
+	}
 
-		for(j=0; j<7; j++)
-			if(bit_index / 8 < src_buf_size){
-				encoded_byte |= ((src_buf[bit_index / 8] >> (bit_index % 8)) & 0x01) << j;
-				bit_index++;
-			}
+	// Last partial group: at most 6 + 8 bits are pending.
+	uint16_t pending = 0;
+	uint8_t pending_bits = 0;
 
-		if(master)
-			encoded_byte |= 0x80;
+	for(; src_buf_size > 0; src_buf_size--){
+		pending |= (uint16_t) *src_buf++ << pending_bits;
+		pending_bits += 8;
 
-		dest_buf[i] = encoded_byte;
+		for(; pending_bits >= 7; pending_bits -= 7){
+			*dest_buf++ = (pending & 0x7F) | msb;
+			pending >>= 7;
+		}
 	}
 
+	if(pending_bits > 0)
+		*dest_buf = (pending & 0x7F) | msb;
+
 	return UL_OK;
 }
 
@@ -71,23 +149,33 @@ ul_err_t __decode_message(uint8_t *dest_buf, uint8_t *src_buf, UL_MS_BUF_SIZE_T
 	assert_param_notnull(src_buf);
 	assert_param_size_ok(src_buf_size);
 
-	uint32_t bit_index = 0;
-	uint8_t decoded_byte, j;
-	UL_MS_BUF_SIZE_T i, dest_buf_size = ul_ms_compute_decoded_size(src_buf_size);
+	// The MSb is ignored on both sides.
+	if(src_buf_size == MS_PAYLOAD_3_ENCODED_SIZE){
+		__decode_payload_3(dest_buf, src_buf);
+		return UL_OK;
+	}
 
-	memset(dest_buf, 0, dest_buf_size);
+	for(; src_buf_size >= MS_GROUP_ENCODED_SIZE; src_buf_size -= MS_GROUP_ENCODED_SIZE){
+		__decode_group(dest_buf, src_buf);
 
-	for(i=0; i<src_buf_size; i++)
-		for(j=0; j<7; j++)
-			if(bit_index / 8 < dest_buf_size){
-				decoded_byte = (src_buf[i] >> j) & 0x01;
+		src_buf += MS_GROUP_ENCODED_SIZE;
+		dest_buf += MS_GROUP_DECODED_SIZE;
+	}
+
+	// Last partial group: the trailing padding bits are dropped.
+	uint16_t pending = 0;
+	uint8_t pending_bits = 0;
 
-				if(!master)
-					decoded_byte &= 0x7F;
+	for(; src_buf_size > 0; src_buf_size--){
+		pending |= (uint16_t) (*src_buf++ & 0x7F) << pending_bits;
+		pending_bits += 7;
 
-				dest_buf[bit_index / 8] |= decoded_byte << (bit_index % 8);
-				bit_index++;
-			}
+		if(pending_bits >= 8){
+			*dest_buf++ = pending;
+			pending >>= 8;
+			pending_bits -= 8;
+		}
+	}
 
 	return UL_OK;
 }
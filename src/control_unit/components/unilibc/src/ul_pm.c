@@ -39,10 +39,680 @@
 * Private Functions Prototypes
  ************************************************************************************************************/
 
+/**
+ * @brief Clear the partial sums.
+ */
+static void __sums_reset(ul_pm_sums_t *sums);
+
+/**
+ * @brief Evaluate the averages, the variances and the covariance of the partial sums (raw ADC units).
+ */
+static void __sums_evaluate(ul_pm_sums_t *sums, float *v_avg, float *i_avg, float *v_variance, float *i_variance, float *covariance);
+
+/**
+ * @brief Initialize a stream with the DC offsets estimate at mid-scale and the zero-crossing tracking unlocked.
+ */
+static void __stream_init(ul_pm_handle_t *self, ul_pm_stream_t *stream, uint32_t window_samples, uint8_t window_cycles);
+
+/**
+ * @brief Start the next window of a stream, keeping the zero-crossing tracking.
+ */
+static void __stream_next_window(ul_pm_stream_t *stream, uint16_t v_offset, uint16_t i_offset);
+
+/**
+ * @brief Handle a rising zero-crossing of the voltage.
+ * @param v_val The first voltage sample after the zero-crossing, relative to `v_offset`.
+ * @return true if the zero-crossing closes the window, so `v_val` belongs to the next one.
+ */
+static bool __stream_zero_crossing(ul_pm_handle_t *self, ul_pm_stream_t *stream, int32_t v_val);
+
+/**
+ * @brief Accumulate a single pair of samples.
+ * @return false if the pair was not accumulated because the window is complete.
+ */
+static inline bool __stream_update(ul_pm_handle_t *self, ul_pm_stream_t *stream, uint16_t v_sample, uint16_t i_sample);
+
+/**
+ * @brief Accumulate a chunk of samples, with saturation to `ul_pm_init_t::adc_value_at_adc_vcc`.
+ * @return The number of accumulated samples.
+ */
+static uint32_t __stream_feed(
+	ul_pm_handle_t *self,
+	ul_pm_stream_t *stream,
+
+	#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+		uint16_t *v_samples,
+		uint16_t *i_samples,
+	#else
+		void *user_context,
+	#endif
+
+	uint32_t samples_len
+);
+
+/**
+ * @brief Accumulate a chunk of samples read in place from a raw interleaved buffer.
+ * @return The number of accumulated samples.
+ */
+static uint32_t __stream_feed_span(
+	ul_pm_handle_t *self,
+	ul_pm_stream_t *stream,
+	const uint8_t *buffer,
+	const ul_pm_span_t *v_span,
+	const ul_pm_span_t *i_span,
+	uint32_t samples_len
+);
+
+/**
+ * @brief Check a `ul_pm_span_t`.
+ */
+static ul_err_t __span_check(const ul_pm_span_t *span);
+
+#ifdef UL_CONFIG_PM_HARMONICS
+
+/**
+ * @brief Tune the Goertzel filters on `ul_pm_stream_t::harmonics_cycle_len` and clear their state.
+ */
+static void __harmonics_tune(ul_pm_stream_t *stream);
+
+/**
+ * @brief Clear the Goertzel filters state.
+ */
+static void __harmonics_reset(ul_pm_stream_t *stream);
+
+/**
+ * @brief Feed a single pair of samples (relative to the DC offsets estimate) to the Goertzel filters.
+ */
+static inline void __harmonics_update(ul_pm_stream_t *stream, int32_t v_val, int32_t i_val);
+
+/**
+ * @brief Convert the Goertzel filters state to the `ul_pm_results_t` harmonics fields.
+ */
+static void __harmonics_evaluate(ul_pm_handle_t *self, ul_pm_stream_t *stream, ul_pm_results_t *res);
+
+#endif
+
+/**
+ * @brief Convert the partial sums to `ul_pm_results_t`.
+ */
+static void __stream_evaluate(ul_pm_handle_t *self, ul_pm_stream_t *stream, ul_pm_results_t *res);
+
+/**
+ * @brief Clear the partial sums of every circuit.
+ */
+static void __circuits_reset(ul_pm_circuits_t *self);
+
+/**
+ * @brief Accumulate a chunk of samples of every circuit.
+ */
+static void __circuits_feed(ul_pm_circuits_t *self, const uint16_t *v_samples, const uint16_t *i_samples, uint32_t i_stride, uint32_t samples_len);
+
 /************************************************************************************************************
 * Private Functions Definitions
  ************************************************************************************************************/
 
+void __sums_reset(ul_pm_sums_t *sums){
+	sums->samples_len = 0;
+	sums->v_sum = sums->i_sum = 0;
+	sums->v_quadratic_sum = sums->i_quadratic_sum = 0;
+	sums->instant_power_sum = 0;
+}
+
+void __sums_evaluate(ul_pm_sums_t *sums, float *v_avg, float *i_avg, float *v_variance, float *i_variance, float *covariance){
+
+	float samples_len = sums->samples_len;
+
+	// Averages relative to the DC offsets estimate.
+	*v_avg = (float) sums->v_sum / samples_len;
+	*i_avg = (float) sums->i_sum / samples_len;
+
+	#ifdef UL_CONFIG_PM_FIXED_POINT
+
+	/**
+	 * `n * sum(x^2) - sum(x)^2` is exact in 64-bit integer arithmetic
+	 * (e.g. 4000 samples of 12 bits need less than 50 bits):
+	 * only the final division is done in floating point.
+	 */
+	int64_t n = sums->samples_len;
+	float n_squared = samples_len * samples_len;
+
+	*v_variance = (n * sums->v_quadratic_sum - (int64_t) sums->v_sum * sums->v_sum) / n_squared;
+	*i_variance = (n * sums->i_quadratic_sum - (int64_t) sums->i_sum * sums->i_sum) / n_squared;
+	*covariance = (n * sums->instant_power_sum - (int64_t) sums->v_sum * sums->i_sum) / n_squared;
+
+	#else
+
+	/**
+	 * Mean of the squares minus the square of the mean:
+	 * since the sums are relative to the DC offsets estimate, `v_avg` and `i_avg` are small
+	 * and the subtraction does not suffer from cancellation.
+	 */
+	*v_variance = sums->v_quadratic_sum / samples_len - *v_avg * *v_avg;
+	*i_variance = sums->i_quadratic_sum / samples_len - *i_avg * *i_avg;
+	*covariance = sums->instant_power_sum / samples_len - *v_avg * *i_avg;
+
+	#endif
+
+	if(*v_variance < 0)
+		*v_variance = 0;
+
+	if(*i_variance < 0)
+		*i_variance = 0;
+}
+
+void __stream_init(ul_pm_handle_t *self, ul_pm_stream_t *stream, uint32_t window_samples, uint8_t window_cycles){
+	uint16_t adc_mid_scale = self->init.adc_value_at_adc_vcc / 2;
+
+	// Zero-crossing tracking unlocked.
+	*stream = (ul_pm_stream_t){
+		.window_samples = window_samples,
+		.window_cycles = window_cycles
+	};
+
+	#ifdef UL_CONFIG_PM_HARMONICS
+	if(self->init.sample_rate_hz > 0 && self->init.nominal_frequency_hz > 0)
+		stream->harmonics_cycle_len = self->init.sample_rate_hz / self->init.nominal_frequency_hz;
+	#endif
+
+	__stream_next_window(stream, adc_mid_scale, adc_mid_scale);
+}
+
+void __stream_next_window(ul_pm_stream_t *stream, uint16_t v_offset, uint16_t i_offset){
+
+	// Make the last zero-crossing relative to the start of the new window.
+	stream->zc_last -= stream->sums.samples_len;
+
+	/**
+	 * Start over if the window did not end on a zero-crossing while it should have (no mains),
+	 * or if there was no zero-crossing at all: `zc_last` would be too old to measure the next cycle.
+	 */
+	if(
+		(stream->window_cycles > 0 && stream->cycles < stream->window_cycles) ||
+		stream->cycles == 0
+	)
+		stream->zc_locked = false;
+
+	#ifdef UL_CONFIG_PM_HARMONICS
+
+	// Follow the mains frequency.
+	if(stream->cycles > 0)
+		stream->harmonics_cycle_len = stream->cycles_len / stream->cycles;
+
+	__harmonics_tune(stream);
+
+	#endif
+
+	__sums_reset(&stream->sums);
+	__sums_reset(&stream->cycle_start);
+
+	stream->v_offset = v_offset;
+	stream->i_offset = i_offset;
+
+	stream->v_min = stream->i_min = 0xFFFF;
+	stream->v_max = stream->i_max = 0;
+
+	stream->cycles = 0;
+	stream->cycles_len = 0;
+	stream->window_ready = false;
+}
+
+bool __stream_zero_crossing(ul_pm_handle_t *self, ul_pm_stream_t *stream, int32_t v_val){
+
+	// Linear interpolation between `v_prev` (< 0) and `v_val` (>= 0).
+	float position = stream->sums.samples_len - (float) v_val / (v_val - stream->v_prev);
+
+	if(!stream->zc_locked){
+		stream->zc_locked = true;
+		stream->zc_last = position;
+
+		// Cycle-aligned windows: drop the samples before the first zero-crossing.
+		if(stream->window_cycles > 0 && stream->sums.samples_len > 0){
+			stream->dropped_len = stream->sums.samples_len;
+			stream->zc_last -= stream->sums.samples_len;
+			__sums_reset(&stream->sums);
+
+			stream->v_min = stream->i_min = 0xFFFF;
+			stream->v_max = stream->i_max = 0;
+
+			#ifdef UL_CONFIG_PM_HARMONICS
+			__harmonics_reset(stream);
+			#endif
+		}
+
+		stream->cycle_start = stream->sums;
+		return false;
+	}
+
+	float cycle_len = position - stream->zc_last;
+
+	stream->cycles++;
+	stream->cycles_len += cycle_len;
+
+	/**
+	 * Skip the per-cycle results if the cycle started on the previous window
+	 * (only with `window_cycles == 0`): its first samples are not in `sums`.
+	 */
+	if(self->init.cycle_callback != NULL && stream->zc_last > -1){
+		ul_pm_sums_t cycle = stream->sums;
+		ul_pm_cycle_results_t res;
+
+		float v_avg, i_avg, v_variance, i_variance, covariance;
+
+		// Per-cycle sums.
+		cycle.samples_len -= stream->cycle_start.samples_len;
+		cycle.v_sum -= stream->cycle_start.v_sum;
+		cycle.i_sum -= stream->cycle_start.i_sum;
+		cycle.v_quadratic_sum -= stream->cycle_start.v_quadratic_sum;
+		cycle.i_quadratic_sum -= stream->cycle_start.i_quadratic_sum;
+		cycle.instant_power_sum -= stream->cycle_start.instant_power_sum;
+
+		if(cycle.samples_len > 0){
+			__sums_evaluate(&cycle, &v_avg, &i_avg, &v_variance, &i_variance, &covariance);
+
+			res.frequency_hz = self->init.sample_rate_hz / cycle_len;
+			res.v_rms = sqrt(v_variance) * self->k_v;
+			res.i_rms = sqrt(i_variance) * self->k_i;
+			res.p_w = covariance * self->k_v * self->k_i;
+
+			self->init.cycle_callback(self->init.cycle_callback_context, &res);
+		}
+	}
+
+	stream->cycle_start = stream->sums;
+	stream->zc_last = position;
+
+	if(stream->window_cycles > 0 && stream->cycles >= stream->window_cycles){
+		stream->window_ready = true;
+		return true;
+	}
+
+	return false;
+}
+
+inline bool __stream_update(ul_pm_handle_t *self, ul_pm_stream_t *stream, uint16_t v_sample, uint16_t i_sample){
+
+	// Remove the DC offsets estimate.
+	int32_t v_val = (int32_t) v_sample - stream->v_offset;
+	int32_t i_val = (int32_t) i_sample - stream->i_offset;
+
+	// Rising zero-crossing detection with hysteresis.
+	if(v_val < -self->zc_hysteresis)
+		stream->zc_armed = true;
+
+	else if(stream->zc_armed && v_val >= 0){
+		stream->zc_armed = false;
+
+		if(__stream_zero_crossing(self, stream, v_val)){
+			stream->v_prev = v_val;
+			return false;
+		}
+	}
+
+	stream->v_prev = v_val;
+
+	ul_pm_sums_t *sums = &stream->sums;
+
+	sums->v_sum += v_val;
+	sums->i_sum += i_val;
+
+	// Begin computing the RMS.
+	sums->v_quadratic_sum += (ul_pm_quadratic_sum_t) (v_val * v_val);
+	sums->i_quadratic_sum += (ul_pm_quadratic_sum_t) (i_val * i_val);
+
+	// Sum of all the instant powers.
+	sums->instant_power_sum += (ul_pm_quadratic_sum_t) (v_val * i_val);
+
+	// Find the peaks.
+	if(v_sample > stream->v_max)
+		stream->v_max = v_sample;
+
+	if(v_sample < stream->v_min)
+		stream->v_min = v_sample;
+
+	if(i_sample > stream->i_max)
+		stream->i_max = i_sample;
+
+	if(i_sample < stream->i_min)
+		stream->i_min = i_sample;
+
+	#ifdef UL_CONFIG_PM_HARMONICS
+	if(stream->harmonics_cycle_len > 0)
+		__harmonics_update(stream, v_val, i_val);
+	#endif
+
+	sums->samples_len++;
+
+	if(stream->window_samples > 0 && sums->samples_len >= stream->window_samples)
+		stream->window_ready = true;
+
+	return true;
+}
+
+uint32_t __stream_feed(
+	ul_pm_handle_t *self,
+	ul_pm_stream_t *stream,
+
+	#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+		uint16_t *v_samples,
+		uint16_t *i_samples,
+	#else
+		void *user_context,
+	#endif
+
+	uint32_t samples_len
+){
+
+	uint16_t adc_max = self->init.adc_value_at_adc_vcc;
+	uint16_t v_sample, i_sample;
+	uint32_t i;
+
+	stream->dropped_len = 0;
+
+	for(i=0; i<samples_len && !stream->window_ready; i++){
+
+		// Saturation.
+		v_sample = v_samples_get(i);
+		if(v_sample > adc_max)
+			v_sample = adc_max;
+
+		i_sample = i_samples_get(i);
+		if(i_sample > adc_max)
+			i_sample = adc_max;
+
+		if(!__stream_update(self, stream, v_sample, i_sample))
+			break;
+	}
+
+	return i;
+}
+
+uint32_t __stream_feed_span(
+	ul_pm_handle_t *self,
+	ul_pm_stream_t *stream,
+	const uint8_t *buffer,
+	const ul_pm_span_t *v_span,
+	const ul_pm_span_t *i_span,
+	uint32_t samples_len
+){
+
+	uint16_t adc_max = self->init.adc_value_at_adc_vcc;
+	uint16_t v_sample, i_sample;
+	uint32_t i;
+
+	stream->dropped_len = 0;
+
+	const uint8_t *v_ptr = buffer + v_span->offset_bytes;
+	const uint8_t *i_ptr = buffer + i_span->offset_bytes;
+
+	for(i=0; i<samples_len && !stream->window_ready; i++){
+
+		// Little-endian words, read byte by byte to not depend on the buffer alignment.
+		v_sample = ((v_ptr[0] | (v_ptr[1] << 8)) >> v_span->shift) & v_span->mask;
+		i_sample = ((i_ptr[0] | (i_ptr[1] << 8)) >> i_span->shift) & i_span->mask;
+
+		// Saturation.
+		if(v_sample > adc_max)
+			v_sample = adc_max;
+
+		if(i_sample > adc_max)
+			i_sample = adc_max;
+
+		if(!__stream_update(self, stream, v_sample, i_sample))
+			break;
+
+		v_ptr += v_span->stride_bytes;
+		i_ptr += i_span->stride_bytes;
+	}
+
+	return i;
+}
+
+ul_err_t __span_check(const ul_pm_span_t *span){
+	assert_param_notnull(span);
+
+	UL_RETURN_ON_FALSE(
+		span->stride_bytes >= 2,
+
+		UL_ERR_INVALID_ARG,
+		"Error: `span->stride_bytes` is less than 2"
+	);
+
+	UL_RETURN_ON_FALSE(
+		span->shift < 16 && span->mask != 0,
+
+		UL_ERR_INVALID_ARG,
+		"Error: `span->shift` or `span->mask` out of range"
+	);
+
+	return UL_OK;
+}
+
+#ifdef UL_CONFIG_PM_HARMONICS
+
+void __harmonics_tune(ul_pm_stream_t *stream){
+	float w;
+
+	for(uint8_t k=0; k<UL_CONFIG_PM_HARMONICS; k++){
+
+		// Harmonics over the Nyquist frequency (or unknown mains frequency) are disabled.
+		w = (
+			stream->harmonics_cycle_len > 0 ?
+			2 * M_PI * (k + 1) / stream->harmonics_cycle_len :
+			0
+		);
+
+		if(w >= M_PI)
+			w = 0;
+
+		stream->harmonics_cos[k] = cosf(w);
+		stream->harmonics_sin[k] = sinf(w);
+		stream->harmonics_coef[k] = 2 * stream->harmonics_cos[k];
+	}
+
+	__harmonics_reset(stream);
+}
+
+void __harmonics_reset(ul_pm_stream_t *stream){
+	for(uint8_t k=0; k<UL_CONFIG_PM_HARMONICS; k++){
+		stream->v_harmonics_s1[k] = stream->v_harmonics_s2[k] = 0;
+		stream->i_harmonics_s1[k] = stream->i_harmonics_s2[k] = 0;
+	}
+}
+
+inline void __harmonics_update(ul_pm_stream_t *stream, int32_t v_val, int32_t i_val){
+	float v_s0, i_s0;
+
+	// `s[n] = x[n] + 2 * cos(w) * s[n-1] - s[n-2]`
+	for(uint8_t k=0; k<UL_CONFIG_PM_HARMONICS; k++){
+		v_s0 = v_val + stream->harmonics_coef[k] * stream->v_harmonics_s1[k] - stream->v_harmonics_s2[k];
+		stream->v_harmonics_s2[k] = stream->v_harmonics_s1[k];
+		stream->v_harmonics_s1[k] = v_s0;
+
+		i_s0 = i_val + stream->harmonics_coef[k] * stream->i_harmonics_s1[k] - stream->i_harmonics_s2[k];
+		stream->i_harmonics_s2[k] = stream->i_harmonics_s1[k];
+		stream->i_harmonics_s1[k] = i_s0;
+	}
+}
+
+void __harmonics_evaluate(ul_pm_handle_t *self, ul_pm_stream_t *stream, ul_pm_results_t *res){
+
+	float samples_len = stream->sums.samples_len;
+	float v_phase_1 = 0;
+	float v_distortion = 0, i_distortion = 0;
+
+	for(uint8_t k=0; k<UL_CONFIG_PM_HARMONICS; k++){
+		res->v_harmonics_rms[k] = res->v_harmonics_phase[k] = 0;
+		res->i_harmonics_rms[k] = res->i_harmonics_phase[k] = 0;
+	}
+
+	res->v_thd = res->i_thd = 0;
+
+	if(stream->harmonics_cycle_len <= 0)
+		return;
+
+	for(uint8_t k=0; k<UL_CONFIG_PM_HARMONICS; k++){
+
+		// Disabled harmonic.
+		if(stream->harmonics_sin[k] == 0)
+			continue;
+
+		/**
+		 * DFT bin `X(w) = e^(-j*w*N) * (cos(w) * s[N-1] - s[N-2] + j * sin(w) * s[N-1])`;
+		 * `w*N` is reduced to one turn to keep the float precision.
+		 */
+		float turn = 2 * M_PI * fmodf((k + 1) * samples_len / stream->harmonics_cycle_len, 1);
+		float turn_cos = cosf(turn), turn_sin = sinf(turn);
+
+		float v_re = stream->harmonics_cos[k] * stream->v_harmonics_s1[k] - stream->v_harmonics_s2[k];
+		float v_im = stream->harmonics_sin[k] * stream->v_harmonics_s1[k];
+		float i_re = stream->harmonics_cos[k] * stream->i_harmonics_s1[k] - stream->i_harmonics_s2[k];
+		float i_im = stream->harmonics_sin[k] * stream->i_harmonics_s1[k];
+
+		float v_bin_re = v_re * turn_cos + v_im * turn_sin;
+		float v_bin_im = v_im * turn_cos - v_re * turn_sin;
+		float i_bin_re = i_re * turn_cos + i_im * turn_sin;
+		float i_bin_im = i_im * turn_cos - i_re * turn_sin;
+
+		// A sinusoid of amplitude `A` gives `|X| = A * N / 2`, so its RMS value is `|X| * sqrt(2) / N`.
+		res->v_harmonics_rms[k] = sqrt(v_bin_re * v_bin_re + v_bin_im * v_bin_im) * M_SQRT2 / samples_len * self->k_v;
+		res->i_harmonics_rms[k] = sqrt(i_bin_re * i_bin_re + i_bin_im * i_bin_im) * M_SQRT2 / samples_len * self->k_i;
+
+		float v_phase = atan2f(v_bin_im, v_bin_re);
+		float i_phase = atan2f(i_bin_im, i_bin_re);
+
+		if(k == 0)
+			v_phase_1 = v_phase;
+
+		// Relative to the voltage fundamental, wrapped to [-180, 180) degrees.
+		v_phase -= (k + 1) * v_phase_1;
+		i_phase -= (k + 1) * v_phase_1;
+
+		res->v_harmonics_phase[k] = (v_phase - 2 * M_PI * floorf(v_phase / (2 * M_PI) + 0.5)) * 180 / M_PI;
+		res->i_harmonics_phase[k] = (i_phase - 2 * M_PI * floorf(i_phase / (2 * M_PI) + 0.5)) * 180 / M_PI;
+
+		if(k > 0){
+			v_distortion += res->v_harmonics_rms[k] * res->v_harmonics_rms[k];
+			i_distortion += res->i_harmonics_rms[k] * res->i_harmonics_rms[k];
+		}
+	}
+
+	if(res->v_harmonics_rms[0] > 0)
+		res->v_thd = sqrt(v_distortion) / res->v_harmonics_rms[0] * 100;
+
+	if(res->i_harmonics_rms[0] > 0)
+		res->i_thd = sqrt(i_distortion) / res->i_harmonics_rms[0] * 100;
+}
+
+#endif
+
+void __stream_evaluate(ul_pm_handle_t *self, ul_pm_stream_t *stream, ul_pm_results_t *res){
+
+	float v_avg, i_avg, v_variance, i_variance, covariance;
+	__sums_evaluate(&stream->sums, &v_avg, &i_avg, &v_variance, &i_variance, &covariance);
+
+	// Convert the raw peaks to AC voltage/current.
+	res->v_pos_peak = ((float) stream->v_max - stream->v_offset - v_avg) * self->k_v;
+	res->v_neg_peak = ((float) stream->v_min - stream->v_offset - v_avg) * self->k_v;
+	res->i_pos_peak = ((float) stream->i_max - stream->i_offset - i_avg) * self->k_i;
+	res->i_neg_peak = ((float) stream->i_min - stream->i_offset - i_avg) * self->k_i;
+
+	res->v_pp = res->v_pos_peak - res->v_neg_peak;
+	res->i_pp = res->i_pos_peak - res->i_neg_peak;
+
+	res->v_rms = sqrt(v_variance) * self->k_v;
+	res->i_rms = sqrt(i_variance) * self->k_i;
+
+	res->frequency_hz = (
+		stream->cycles > 0 ?
+		stream->cycles * self->init.sample_rate_hz / stream->cycles_len :
+		0
+	);
+
+	#ifdef UL_CONFIG_PM_HARMONICS
+	__harmonics_evaluate(self, stream, res);
+	#endif
+
+	if(
+		res->v_rms < self->init.v_rms_threshold ||
+		res->i_rms < self->init.i_rms_threshold
+	){
+		res->p_va = res->p_w = res->p_var = res->p_pf = 0;
+
+		if(res->v_rms < self->init.v_rms_threshold){
+			res->v_rms = 0;
+			res->frequency_hz = 0;
+
+			#ifdef UL_CONFIG_PM_HARMONICS
+			for(uint8_t k=0; k<UL_CONFIG_PM_HARMONICS; k++)
+				res->v_harmonics_rms[k] = res->v_harmonics_phase[k] = 0;
+
+			res->v_thd = 0;
+			#endif
+		}
+
+		if(res->i_rms < self->init.i_rms_threshold){
+			res->i_rms = 0;
+
+			#ifdef UL_CONFIG_PM_HARMONICS
+			for(uint8_t k=0; k<UL_CONFIG_PM_HARMONICS; k++)
+				res->i_harmonics_rms[k] = res->i_harmonics_phase[k] = 0;
+
+			res->i_thd = 0;
+			#endif
+		}
+	}
+
+	else {
+		res->p_va = res->v_rms * res->i_rms;
+		res->p_w = covariance * self->k_v * self->k_i;
+
+		// Rounding errors can make `p_w` slightly greater than `p_va` with purely resistive loads.
+		res->p_var = pow(res->p_va, 2) - pow(res->p_w, 2);
+		res->p_var = (res->p_var > 0 ? sqrt(res->p_var) : 0);
+
+		res->p_pf = res->p_w / res->p_va;
+	}
+}
+
+void __circuits_reset(ul_pm_circuits_t *self){
+	self->samples_len = 0;
+	self->v_sum = 0;
+	self->v_quadratic_sum = 0;
+
+	for(uint8_t c=0; c<self->len; c++){
+		self->i_sum[c] = 0;
+		self->i_quadratic_sum[c] = 0;
+		self->instant_power_sum[c] = 0;
+	}
+}
+
+void __circuits_feed(ul_pm_circuits_t *self, const uint16_t *v_samples, const uint16_t *i_samples, uint32_t i_stride, uint32_t samples_len){
+
+	uint16_t adc_max = self->pm->init.adc_value_at_adc_vcc;
+	int32_t v_offset = self->pm->stream.v_offset;
+	int32_t v_val, i_val;
+	uint16_t i_sample;
+
+	// A single pass: every voltage sample is read once and shared by all the circuits.
+	for(uint32_t j=0; j<samples_len; j++){
+		v_val = (v_samples[j] > adc_max ? adc_max : v_samples[j]) - v_offset;
+
+		self->v_sum += v_val;
+		self->v_quadratic_sum += (ul_pm_quadratic_sum_t) (v_val * v_val);
+
+		for(uint8_t c=0; c<self->len; c++){
+			i_sample = i_samples[c * i_stride + j];
+			i_val = (i_sample > adc_max ? adc_max : i_sample) - self->i_offset[c];
+
+			self->i_sum[c] += i_val;
+			self->i_quadratic_sum[c] += (ul_pm_quadratic_sum_t) (i_val * i_val);
+			self->instant_power_sum[c] += (ul_pm_quadratic_sum_t) (v_val * i_val);
+		}
+	}
+
+	self->samples_len += samples_len;
+}
+
 /************************************************************************************************************
 * Public Functions Definitions
  ************************************************************************************************************/
@@ -155,14 +825,22 @@ ul_err_t ul_pm_begin(ul_pm_init_t *init, ul_pm_handle_t **returned_handle){
 		"Error: `init->i_correction_factor` is less or equal to 0"
 	);
 
-	#ifndef UL_CONFIG_PM_DOUBLE_BUFFER
+	UL_GOTO_ON_FALSE(
+		init->sample_rate_hz >= 0,
+
+		UL_ERR_INVALID_ARG,
+		label_error,
+		"Error: `init->sample_rate_hz` is less than 0"
+	);
+
+	#ifdef UL_CONFIG_PM_HARMONICS
 
 	UL_GOTO_ON_FALSE(
-		init->sample_callback != NULL,
+		init->nominal_frequency_hz >= 0,
 
 		UL_ERR_INVALID_ARG,
 		label_error,
-		"Error: `init->sample_callback` is NULL"
+		"Error: `init->nominal_frequency_hz` is less than 0"
 	);
 
 	#endif
@@ -173,6 +851,10 @@ ul_err_t ul_pm_begin(ul_pm_init_t *init, ul_pm_handle_t **returned_handle){
 	self->k_v = self->init.v_correction_factor * resolution * (self->init.v_divider_r1_ohm + self->init.v_divider_r2_ohm) / (self->init.v_transformer_gain * self->init.v_divider_r2_ohm);
 	self->k_i = self->init.i_correction_factor * resolution / (self->init.i_clamp_gain * self->init.i_clamp_resistor_ohm);
 
+	self->zc_hysteresis = lroundf(self->init.v_rms_threshold / self->k_v);
+
+	ul_pm_stream_begin(self);
+
 	*returned_handle = self;
 	return ret;
 
@@ -204,79 +886,249 @@ ul_err_t ul_pm_evaluate(
 	#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
 	assert_param_notnull(v_samples);
 	assert_param_notnull(i_samples);
+
+	#else
+	UL_RETURN_ON_FALSE(
+		self->init.sample_callback != NULL,
+
+		UL_ERR_INVALID_STATE,
+		"Error: `init->sample_callback` was NULL; use the `*_span()` functions instead"
+	);
+
 	#endif
 
 	assert_param_size_ok(samples_len);
 	assert_param_notnull(res);
 
-	// Knuth running mean.
-	float v_samples_avg = 0, i_samples_avg = 0, tmp;
+	// No window limits: evaluate every sample.
+	ul_pm_stream_t stream;
+	__stream_init(self, &stream, 0, 0);
 
-	for(int i=0; i<samples_len; i++){
+	// Single pass over the samples.
+	__stream_feed(
+		self,
+		&stream,
 
-		// Saturation.
-		tmp = v_samples_get(i);
-		if(tmp > self->init.adc_value_at_adc_vcc)
-			tmp = self->init.adc_value_at_adc_vcc;
+		#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+			v_samples,
+			i_samples,
+		#else
+			user_context,
+		#endif
 
-		v_samples_avg += (tmp - v_samples_avg) / (i + 1);
+		samples_len
+	);
 
-		// Saturation.
-		tmp = i_samples_get(i);
-		if(tmp > self->init.adc_value_at_adc_vcc)
-			tmp = self->init.adc_value_at_adc_vcc;
+	__stream_evaluate(self, &stream, res);
+	return UL_OK;
+}
 
-		i_samples_avg += (tmp - i_samples_avg) / (i + 1);
-	}
+ul_err_t ul_pm_stream_begin(ul_pm_handle_t *self){
+	assert_param_notnull(self);
 
-	float v_quadratic_sum = 0, i_quadratic_sum = 0;
-	float instant_power_sum = 0;
-	float v_val, i_val;
+	__stream_init(
+		self,
+		&self->stream,
+		self->init.window_samples,
+		self->init.cycles_per_window
+	);
 
-	res->v_pos_peak = res->i_pos_peak = -0xFFFF;
-	res->v_neg_peak = res->i_neg_peak = 0xFFFF;
+	return UL_OK;
+}
 
-	for(int i=0; i<samples_len; i++){
+ul_err_t ul_pm_stream_feed(
+	ul_pm_handle_t *self,
 
-		// Remove the average from the sample and convert to AC voltage/current.
-		v_val = ((float) v_samples_get(i) - v_samples_avg) * self->k_v;
-		i_val = ((float) i_samples_get(i) - i_samples_avg) * self->k_i;
+	#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+		uint16_t *v_samples,
+		uint16_t *i_samples,
+	#else
+		void *user_context,
+	#endif
 
-		// Begin computing the RMS.
-		v_quadratic_sum += pow(v_val, 2);
-		i_quadratic_sum += pow(i_val, 2);
+	uint32_t samples_len,
+	uint32_t *consumed_len
+){
 
-		// Sum of all the instant powers.
-		instant_power_sum += v_val * i_val;
+	assert_param_notnull(self);
 
-		// Find the peaks.
-		if(v_val > res->v_pos_peak)
-			res->v_pos_peak = v_val;
+	#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+	assert_param_notnull(v_samples);
+	assert_param_notnull(i_samples);
 
-		if(v_val < res->v_neg_peak)
-			res->v_neg_peak = v_val;
+	#else
+	UL_RETURN_ON_FALSE(
+		self->init.sample_callback != NULL,
 
-		if(i_val > res->i_pos_peak)
-			res->i_pos_peak = i_val;
+		UL_ERR_INVALID_STATE,
+		"Error: `init->sample_callback` was NULL; use the `*_span()` functions instead"
+	);
 
-		if(i_val < res->i_neg_peak)
-			res->i_neg_peak = i_val;
-	}
+	#endif
 
-	res->v_pp = res->v_pos_peak - res->v_neg_peak;
-	res->i_pp = res->i_pos_peak - res->i_neg_peak;
+	assert_param_notnull(consumed_len);
 
-	res->v_rms = sqrt(v_quadratic_sum / samples_len);
-	res->i_rms = sqrt(i_quadratic_sum / samples_len);
+	*consumed_len = __stream_feed(
+		self,
+		&self->stream,
 
-	if(
-		res->v_rms < self->init.v_rms_threshold ||
-		res->i_rms < self->init.i_rms_threshold
-	){
+		#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+			v_samples,
+			i_samples,
+		#else
+			user_context,
+		#endif
+
+		samples_len
+	);
+
+	return UL_OK;
+}
+
+ul_err_t ul_pm_evaluate_span(ul_pm_handle_t *self, const void *buffer, const ul_pm_span_t *v_span, const ul_pm_span_t *i_span, uint32_t samples_len, ul_pm_results_t *res){
+	assert_param_notnull(self);
+	assert_param_notnull(buffer);
+	assert_param_size_ok(samples_len);
+	assert_param_notnull(res);
+
+	UL_RETURN_ON_ERROR(
+		__span_check(v_span),
+		"Error on `__span_check(v_span)`"
+	);
+
+	UL_RETURN_ON_ERROR(
+		__span_check(i_span),
+		"Error on `__span_check(i_span)`"
+	);
+
+	// No window limits: evaluate every sample.
+	ul_pm_stream_t stream;
+	__stream_init(self, &stream, 0, 0);
+	__stream_feed_span(self, &stream, buffer, v_span, i_span, samples_len);
+	__stream_evaluate(self, &stream, res);
+
+	return UL_OK;
+}
+
+ul_err_t ul_pm_stream_feed_span(ul_pm_handle_t *self, const void *buffer, const ul_pm_span_t *v_span, const ul_pm_span_t *i_span, uint32_t samples_len, uint32_t *consumed_len, uint32_t *dropped_len){
+	assert_param_notnull(self);
+	assert_param_notnull(buffer);
+	assert_param_notnull(consumed_len);
+	assert_param_notnull(dropped_len);
+
+	UL_RETURN_ON_ERROR(
+		__span_check(v_span),
+		"Error on `__span_check(v_span)`"
+	);
+
+	UL_RETURN_ON_ERROR(
+		__span_check(i_span),
+		"Error on `__span_check(i_span)`"
+	);
+
+	*consumed_len = __stream_feed_span(self, &self->stream, buffer, v_span, i_span, samples_len);
+	*dropped_len = self->stream.dropped_len;
+
+	return UL_OK;
+}
+
+bool ul_pm_stream_window_ready(ul_pm_handle_t *self){
+	return self != NULL && self->stream.window_ready;
+}
+
+ul_err_t ul_pm_stream_finalize(ul_pm_handle_t *self, ul_pm_results_t *res){
+	assert_param_notnull(self);
+	assert_param_notnull(res);
+
+	ul_pm_stream_t *stream = &self->stream;
+
+	UL_RETURN_ON_FALSE(
+		stream->sums.samples_len > 0,
+
+		UL_ERR_INVALID_STATE,
+		"Error: no samples were fed to the current window"
+	);
+
+	__stream_evaluate(self, stream, res);
+
+	// The next window starts from the DC offsets measured on this one.
+	__stream_next_window(
+		stream,
+		stream->v_offset + lroundf((float) stream->sums.v_sum / stream->sums.samples_len),
+		stream->i_offset + lroundf((float) stream->sums.i_sum / stream->sums.samples_len)
+	);
+
+	return UL_OK;
+}
+
+ul_err_t ul_pm_stream_aggregate(ul_pm_handle_t *self, ul_pm_aggregate_t *aggregate){
+	assert_param_notnull(self);
+	assert_param_notnull(aggregate);
+
+	ul_pm_stream_t *stream = &self->stream;
+	float v_avg, i_avg, v_variance, i_variance, covariance;
+
+	if(stream->sums.samples_len == 0)
+		return UL_OK;
+
+	__sums_evaluate(&stream->sums, &v_avg, &i_avg, &v_variance, &i_variance, &covariance);
+
+	// Per-sample moments back to sums: they no longer depend on the DC offsets estimate of this window.
+	aggregate->samples_len += stream->sums.samples_len;
+	aggregate->v_quadratic_sum += (double) v_variance * stream->sums.samples_len;
+	aggregate->i_quadratic_sum += (double) i_variance * stream->sums.samples_len;
+	aggregate->instant_power_sum += (double) covariance * stream->sums.samples_len;
+
+	aggregate->cycles += stream->cycles;
+	aggregate->cycles_len += stream->cycles_len;
+
+	return UL_OK;
+}
+
+ul_err_t ul_pm_aggregate_merge(ul_pm_aggregate_t *dst, const ul_pm_aggregate_t *src){
+	assert_param_notnull(dst);
+	assert_param_notnull(src);
+
+	dst->samples_len += src->samples_len;
+	dst->v_quadratic_sum += src->v_quadratic_sum;
+	dst->i_quadratic_sum += src->i_quadratic_sum;
+	dst->instant_power_sum += src->instant_power_sum;
+
+	dst->cycles += src->cycles;
+	dst->cycles_len += src->cycles_len;
+
+	return UL_OK;
+}
+
+ul_err_t ul_pm_aggregate_evaluate(ul_pm_handle_t *self, const ul_pm_aggregate_t *aggregate, ul_pm_aggregate_results_t *res){
+	assert_param_notnull(self);
+	assert_param_notnull(aggregate);
+	assert_param_notnull(res);
+
+	UL_RETURN_ON_FALSE(
+		aggregate->samples_len > 0,
+
+		UL_ERR_INVALID_STATE,
+		"Error: no windows were added to `aggregate`"
+	);
+
+	res->v_rms = sqrt(aggregate->v_quadratic_sum / aggregate->samples_len) * self->k_v;
+	res->i_rms = sqrt(aggregate->i_quadratic_sum / aggregate->samples_len) * self->k_i;
+
+	res->frequency_hz = (
+		aggregate->cycles > 0 ?
+		aggregate->cycles * self->init.sample_rate_hz / aggregate->cycles_len :
+		0
+	);
+
+	// Same thresholds of `ul_pm_results_t`.
+	if(res->v_rms < self->init.v_rms_threshold || res->i_rms < self->init.i_rms_threshold){
 		res->p_va = res->p_w = res->p_var = res->p_pf = 0;
 
-		if(res->v_rms < self->init.v_rms_threshold)
+		if(res->v_rms < self->init.v_rms_threshold){
 			res->v_rms = 0;
+			res->frequency_hz = 0;
+		}
 
 		if(res->i_rms < self->init.i_rms_threshold)
 			res->i_rms = 0;
@@ -284,10 +1136,159 @@ ul_err_t ul_pm_evaluate(
 
 	else {
 		res->p_va = res->v_rms * res->i_rms;
-		res->p_w = instant_power_sum / samples_len;
-		res->p_var = sqrt(pow(res->p_va, 2) - pow(res->p_w, 2));
+		res->p_w = aggregate->instant_power_sum / aggregate->samples_len * self->k_v * self->k_i;
+
+		res->p_var = pow(res->p_va, 2) - pow(res->p_w, 2);
+		res->p_var = (res->p_var > 0 ? sqrt(res->p_var) : 0);
+
 		res->p_pf = res->p_w / res->p_va;
 	}
 
 	return UL_OK;
 }
+
+ul_err_t ul_pm_circuits_begin(ul_pm_handle_t *pm, uint8_t circuits_len, ul_pm_circuits_t **returned_handle){
+	assert_param_notnull(pm);
+	assert_param_size_ok(circuits_len);
+	assert_param_notnull(returned_handle);
+
+	ul_err_t ret = UL_OK;
+	ul_pm_circuits_t *self = malloc(sizeof(ul_pm_circuits_t));
+	UL_RETURN_ON_FALSE(
+		self != NULL,
+
+		UL_ERR_NO_MEM,
+		"Error on `malloc(size=%lu)`",
+		sizeof(ul_pm_circuits_t)
+	);
+
+	*self = (ul_pm_circuits_t){
+		.pm = pm,
+		.len = circuits_len,
+		.i_offset = malloc(circuits_len * sizeof(uint16_t)),
+		.i_sum = malloc(circuits_len * sizeof(ul_pm_sum_t)),
+		.i_quadratic_sum = malloc(circuits_len * sizeof(ul_pm_quadratic_sum_t)),
+		.instant_power_sum = malloc(circuits_len * sizeof(ul_pm_quadratic_sum_t))
+	};
+
+	UL_GOTO_ON_FALSE(
+		self->i_offset != NULL &&
+		self->i_sum != NULL &&
+		self->i_quadratic_sum != NULL &&
+		self->instant_power_sum != NULL,
+
+		UL_ERR_NO_MEM,
+		label_error,
+		"Error on `malloc()`"
+	);
+
+	// DC offsets estimate at mid-scale, like `ul_pm_stream_begin()`.
+	for(uint8_t c=0; c<circuits_len; c++)
+		self->i_offset[c] = pm->init.adc_value_at_adc_vcc / 2;
+
+	__circuits_reset(self);
+
+	*returned_handle = self;
+	return ret;
+
+	label_error:
+	ul_pm_circuits_end(self);
+	return ret;
+}
+
+void ul_pm_circuits_end(ul_pm_circuits_t *self){
+	if(self == NULL)
+		return;
+
+	free(self->i_offset);
+	free(self->i_sum);
+	free(self->i_quadratic_sum);
+	free(self->instant_power_sum);
+	free(self);
+}
+
+ul_err_t ul_pm_circuits_feed(ul_pm_circuits_t *self, const uint16_t *v_samples, const uint16_t *i_samples, uint32_t i_stride, uint32_t samples_len, uint32_t dropped_len){
+	assert_param_notnull(self);
+	assert_param_notnull(v_samples);
+	assert_param_notnull(i_samples);
+
+	/**
+	 * The `pm` window dropped the samples before its first zero-crossing (see `ul_pm_init_t::cycles_per_window`):
+	 * drop the same ones, that is the whole circuits window and the first `dropped_len - self->samples_len` of this chunk.
+	 */
+	if(dropped_len > 0){
+		UL_RETURN_ON_FALSE(
+			dropped_len >= self->samples_len && dropped_len - self->samples_len <= samples_len,
+
+			UL_ERR_INVALID_ARG,
+			"Error: `dropped_len` does not match the circuits window"
+		);
+
+		uint32_t skip_len = dropped_len - self->samples_len;
+		__circuits_reset(self);
+
+		v_samples += skip_len;
+		i_samples += skip_len;
+		samples_len -= skip_len;
+	}
+
+	__circuits_feed(self, v_samples, i_samples, i_stride, samples_len);
+	return UL_OK;
+}
+
+ul_err_t ul_pm_circuits_finalize(ul_pm_circuits_t *self, ul_pm_circuit_results_t *res){
+	assert_param_notnull(self);
+	assert_param_notnull(res);
+
+	UL_RETURN_ON_FALSE(
+		self->samples_len > 0,
+
+		UL_ERR_INVALID_STATE,
+		"Error: no samples were fed to the current window"
+	);
+
+	ul_pm_handle_t *pm = self->pm;
+	ul_pm_sums_t sums = {
+		.samples_len = self->samples_len,
+		.v_sum = self->v_sum,
+		.v_quadratic_sum = self->v_quadratic_sum
+	};
+
+	float v_avg, i_avg, v_variance, i_variance, covariance;
+	float v_rms;
+
+	for(uint8_t c=0; c<self->len; c++){
+		sums.i_sum = self->i_sum[c];
+		sums.i_quadratic_sum = self->i_quadratic_sum[c];
+		sums.instant_power_sum = self->instant_power_sum[c];
+
+		__sums_evaluate(&sums, &v_avg, &i_avg, &v_variance, &i_variance, &covariance);
+
+		v_rms = sqrt(v_variance) * pm->k_v;
+		res[c].i_rms = sqrt(i_variance) * pm->k_i;
+
+		// Same thresholds of `ul_pm_results_t`.
+		if(v_rms < pm->init.v_rms_threshold || res[c].i_rms < pm->init.i_rms_threshold){
+			res[c].p_va = res[c].p_w = res[c].p_var = res[c].p_pf = 0;
+
+			if(res[c].i_rms < pm->init.i_rms_threshold)
+				res[c].i_rms = 0;
+		}
+
+		else {
+			res[c].p_va = v_rms * res[c].i_rms;
+			res[c].p_w = covariance * pm->k_v * pm->k_i;
+
+			res[c].p_var = pow(res[c].p_va, 2) - pow(res[c].p_w, 2);
+			res[c].p_var = (res[c].p_var > 0 ? sqrt(res[c].p_var) : 0);
+
+			res[c].p_pf = res[c].p_w / res[c].p_va;
+		}
+
+		// The next window starts from the DC offsets measured on this one.
+		self->i_offset[c] += lroundf(i_avg);
+	}
+
+	__circuits_reset(self);
+	return UL_OK;
+}
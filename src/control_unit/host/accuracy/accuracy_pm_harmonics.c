@@ -0,0 +1,253 @@
+/** @file accuracy_pm_harmonics.c
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	`ul_pm` harmonic analysis accuracy check on synthetic waveforms with known harmonics.
+ * 												Returns `EXIT_FAILURE` if any error is over the tolerances.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+// Standard libraries.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+// UniLibC libraries.
+#include <ul_pm.h>
+
+/************************************************************************************************************
+* Private Defines
+************************************************************************************************************/
+
+#ifndef UL_CONFIG_PM_HARMONICS
+#error "`UL_CONFIG_PM_HARMONICS` is not enabled on `ul_configs.h`"
+#endif
+
+// Same acquisition as the firmware.
+#define SAMPLE_RATE_HZ	20000
+#define CYCLES_PER_WINDOW	2
+#define WINDOW_SAMPLES	4000
+#define STREAM_SAMPLES	(SAMPLE_RATE_HZ * 2)
+#define CHUNK_SAMPLES	100
+
+#define ADC_MID_SCALE	1920
+
+// Tolerances: harmonics RMS error relative to the fundamental RMS, phase error and THD error.
+#define RMS_TOLERANCE	0.002
+#define PHASE_TOLERANCE_DEG	1.0
+#define THD_TOLERANCE	0.2
+
+// Phase check skipped for harmonics under this fraction of the fundamental.
+#define PHASE_MIN_AMPLITUDE	0.02
+
+/************************************************************************************************************
+* Private Types Definitions
+ ************************************************************************************************************/
+
+// `a[k] * cos((k + 1) * w * t + phase_deg[k])`, raw ADC units.
+typedef struct {
+	float a[UL_CONFIG_PM_HARMONICS];
+	float phase_deg[UL_CONFIG_PM_HARMONICS];
+} waveform_t;
+
+typedef struct {
+	const char *name;
+	float frequency_hz;
+	waveform_t v, i;
+} test_case_t;
+
+/************************************************************************************************************
+* Private Variables
+ ************************************************************************************************************/
+
+static const test_case_t __test_cases[] = {
+	{
+		.name = "Pure 50Hz, PF 0.88",
+		.frequency_hz = 50,
+		.v = { .a = { 1200 }, .phase_deg = { 10 } },
+		.i = { .a = { 400 }, .phase_deg = { -20 } }
+	},
+	{
+		.name = "50.3Hz, odd harmonics",
+		.frequency_hz = 50.3,
+		.v = { .a = { 1200, 0, 60, 0, 36 }, .phase_deg = { 0, 0, 30, 0, -60 } },
+		.i = { .a = { 400, 0, 80, 0, 40, 0, 20 }, .phase_deg = { -30, 0, 45, 0, 120, 0, -150 } }
+	},
+	{
+		.name = "49.7Hz, rectifier-like current",
+		.frequency_hz = 49.7,
+		.v = { .a = { 1100, 0, 22 }, .phase_deg = { 90, 0, 0 } },
+		.i = { .a = { 300, 0, 240, 0, 180, 0, 120 }, .phase_deg = { 0, 0, 180, 0, 0, 0, 180 } }
+	}
+};
+
+static uint16_t __v_samples[STREAM_SAMPLES];
+static uint16_t __i_samples[STREAM_SAMPLES];
+
+/************************************************************************************************************
+* Private Functions Definitions
+ ************************************************************************************************************/
+
+static uint16_t __get_sample(void *user_context, ul_pm_sample_type_t sample_type, uint32_t index){
+	uint16_t *samples = (sample_type == UL_PM_SAMPLE_TYPE_VOLTAGE ? __v_samples : __i_samples);
+	return samples[*(uint32_t*) user_context + index];
+}
+
+static float __waveform_sample(const waveform_t *waveform, float frequency_hz, uint32_t n){
+	double t = (double) n / SAMPLE_RATE_HZ;
+	double x = ADC_MID_SCALE;
+
+	for(uint8_t k=0; k<UL_CONFIG_PM_HARMONICS; k++)
+		x += waveform->a[k] * cos(2 * M_PI * (k + 1) * frequency_hz * t + waveform->phase_deg[k] * M_PI / 180);
+
+	return x;
+}
+
+static float __phase_error(float measured, float expected){
+	float err = fmodf(measured - expected + 540, 360) - 180;
+	return fabsf(err);
+}
+
+/**
+ * @brief Compare a channel's harmonics against the expected waveform.
+ * @return Number of errors over the tolerances.
+ */
+static uint32_t __check_channel(const char *channel, const waveform_t *expected, float v_phase_1_deg, float k, const float *rms, const float *phase, float thd){
+	uint32_t errors = 0;
+	float fundamental_rms = expected->a[0] / M_SQRT2 * k;
+	float distortion = 0;
+
+	for(uint8_t h=0; h<UL_CONFIG_PM_HARMONICS; h++){
+		float expected_rms = expected->a[h] / M_SQRT2 * k;
+		float expected_phase = expected->phase_deg[h] - (h + 1) * v_phase_1_deg;
+
+		float rms_err = fabsf(rms[h] - expected_rms) / fundamental_rms;
+		float phase_err = (
+			expected->a[h] >= PHASE_MIN_AMPLITUDE * expected->a[0] ?
+			__phase_error(phase[h], expected_phase) :
+			0
+		);
+
+		bool ok = rms_err <= RMS_TOLERANCE && phase_err <= PHASE_TOLERANCE_DEG;
+		errors += !ok;
+
+		if(h > 0)
+			distortion += expected_rms * expected_rms;
+
+		printf(
+			"    %s%u: rms %9.4f (exp %9.4f, err %.3f%%), phase %8.2f deg (err %.2f)%s\n",
+			channel, h + 1, rms[h], expected_rms, rms_err * 100, phase[h], phase_err, ok ? "" : "  <-- FAIL"
+		);
+	}
+
+	float expected_thd = sqrt(distortion) / fundamental_rms * 100;
+	bool ok = fabsf(thd - expected_thd) <= THD_TOLERANCE;
+	errors += !ok;
+
+	printf("    %s THD: %.3f%% (exp %.3f%%)%s\n", channel, thd, expected_thd, ok ? "" : "  <-- FAIL");
+	return errors;
+}
+
+/************************************************************************************************************
+* Main
+ ************************************************************************************************************/
+
+int main(){
+
+	ul_pm_init_t pm_init = {
+		.adc_vcc_v = 3,
+		.adc_value_at_adc_vcc = 3840,
+
+		.v_transformer_gain = 0.06136,
+		.v_divider_r1_ohm = 10000,
+		.v_divider_r2_ohm = 680,
+
+		.i_clamp_gain = 0.0005,
+		.i_clamp_resistor_ohm = 120,
+
+		.v_rms_threshold = 10,
+		.i_rms_threshold = 0.05,
+
+		.v_correction_factor = 1,
+		.i_correction_factor = 1,
+
+		.sample_rate_hz = SAMPLE_RATE_HZ,
+		.cycles_per_window = CYCLES_PER_WINDOW,
+		.window_samples = WINDOW_SAMPLES,
+		.nominal_frequency_hz = 50,
+
+		#ifndef UL_CONFIG_PM_DOUBLE_BUFFER
+		.sample_callback = __get_sample
+		#endif
+	};
+
+	uint32_t errors = 0;
+
+	for(uint8_t t=0; t<sizeof(__test_cases)/sizeof(__test_cases[0]); t++){
+		const test_case_t *test = &__test_cases[t];
+
+		ul_pm_handle_t *pm_handle;
+		if(ul_pm_begin(&pm_init, &pm_handle) != UL_OK){
+			fprintf(stderr, "Error on `ul_pm_begin()`\n");
+			return EXIT_FAILURE;
+		}
+
+		for(uint32_t n=0; n<STREAM_SAMPLES; n++){
+			__v_samples[n] = lroundf(__waveform_sample(&test->v, test->frequency_hz, n));
+			__i_samples[n] = lroundf(__waveform_sample(&test->i, test->frequency_hz, n));
+		}
+
+		// Stream the samples like `pm.c` and keep the last window.
+		ul_pm_results_t res;
+		uint32_t offset = 0, consumed_len, windows = 0;
+
+		while(offset < STREAM_SAMPLES){
+			uint32_t chunk_len = STREAM_SAMPLES - offset;
+			if(chunk_len > CHUNK_SAMPLES)
+				chunk_len = CHUNK_SAMPLES;
+
+			#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+			ul_pm_stream_feed(pm_handle, &__v_samples[offset], &__i_samples[offset], chunk_len, &consumed_len);
+			#else
+			ul_pm_stream_feed(pm_handle, &offset, chunk_len, &consumed_len);
+			#endif
+
+			offset += consumed_len;
+
+			if(ul_pm_stream_window_ready(pm_handle)){
+				ul_pm_stream_finalize(pm_handle, &res);
+				windows++;
+			}
+		}
+
+		printf("%s: %lu windows, f=%.3fHz\n", test->name, (unsigned long) windows, res.frequency_hz);
+
+		// `ul_pm_results_t` is packed: copy the arrays before passing them around.
+		float v_rms[UL_CONFIG_PM_HARMONICS], v_phase[UL_CONFIG_PM_HARMONICS];
+		float i_rms[UL_CONFIG_PM_HARMONICS], i_phase[UL_CONFIG_PM_HARMONICS];
+
+		for(uint8_t h=0; h<UL_CONFIG_PM_HARMONICS; h++){
+			v_rms[h] = res.v_harmonics_rms[h];
+			v_phase[h] = res.v_harmonics_phase[h];
+			i_rms[h] = res.i_harmonics_rms[h];
+			i_phase[h] = res.i_harmonics_phase[h];
+		}
+
+		errors += __check_channel("V", &test->v, test->v.phase_deg[0], pm_handle->k_v, v_rms, v_phase, res.v_thd);
+		errors += __check_channel("I", &test->i, test->v.phase_deg[0], pm_handle->k_i, i_rms, i_phase, res.i_thd);
+
+		ul_pm_end(pm_handle);
+	}
+
+	printf("%s (%lu errors)\n", errors ? "FAIL" : "PASS", (unsigned long) errors);
+	return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
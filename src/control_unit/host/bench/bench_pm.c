@@ -0,0 +1,265 @@
+/** @file bench_pm.c
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	`ul_pm_evaluate()`, `ul_pm_evaluate_span()` and `ul_pm_circuits_feed()` host benchmark (time and cycles per sample).
+ * 												Build it against both `unilibc` and `unilibc_float` to compare the kernels.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+// Standard libraries.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_CYCLE_COUNTER
+#endif
+
+// UniLibC libraries.
+#include <ul_pm.h>
+
+/************************************************************************************************************
+* Private Defines
+************************************************************************************************************/
+
+// Same window as the firmware default (`CONFIG_PM_ADC_SAMPLES`).
+#define WINDOW_SAMPLES	4000
+#define SAMPLE_RATE_HZ	10000
+#define MAINS_FREQUENCY_HZ	50
+
+// Sub-metered circuits, on top of the main current clamp.
+#define CIRCUITS	4
+
+#define DEFAULT_ITERATIONS	2000
+#define WARMUP_ITERATIONS	50
+
+#ifdef UL_CONFIG_PM_FIXED_POINT
+#define KERNEL_NAME	"fixed"
+#else
+#define KERNEL_NAME	"float"
+#endif
+
+#ifdef UL_CONFIG_PM_HARMONICS
+#define HARMONICS_NAME	"harmonics"
+#else
+#define HARMONICS_NAME	"no harmonics"
+#endif
+
+#define __str2(x)	#x
+#define __str(x)	__str2(x)
+
+#ifdef HAS_CYCLE_COUNTER
+#define __read_cycles()	__rdtsc()
+#else
+#define __read_cycles()	0
+#endif
+
+/**
+ * @brief Run `statement` `iterations` times and print the time per sample and the last `res`.
+ */
+#define bench(name, statement){ \
+	for(uint32_t i=0; i<WARMUP_ITERATIONS; i++) \
+		statement; \
+	\
+	uint64_t start_cycles = __read_cycles(); \
+	uint64_t start_ns = __now_ns(); \
+	\
+	for(uint32_t i=0; i<iterations; i++) \
+		statement; \
+	\
+	uint64_t elapsed_ns = __now_ns() - start_ns; \
+	uint64_t elapsed_cycles = __read_cycles() - start_cycles; \
+	double samples = (double) iterations * WINDOW_SAMPLES; \
+	\
+	printf("  %s\n", name); \
+	printf("    ns/sample:     %.3f\n", elapsed_ns / samples); \
+	\
+	if(elapsed_cycles > 0) \
+		printf("    cycles/sample: %.3f (TSC)\n", elapsed_cycles / samples); \
+	\
+	printf("    V_rms=%.3f I_rms=%.4f P_w=%.3f P_var=%.3f PF=%.4f\n", res.v_rms, res.i_rms, res.p_w, res.p_var, res.p_pf); \
+}
+
+/************************************************************************************************************
+* Private Variables
+ ************************************************************************************************************/
+
+static uint16_t __v_samples[WINDOW_SAMPLES];
+static uint16_t __i_samples[WINDOW_SAMPLES];
+
+// Same samples, interleaved like the ESP32 ADC DMA frames (`data:12`, `channel:4`).
+static uint16_t __raw_samples[2 * WINDOW_SAMPLES];
+
+// Voltage, main current and circuits currents, deinterleaved like the firmware `__pm_task` does.
+static uint16_t __soa_samples[2 + CIRCUITS][WINDOW_SAMPLES];
+
+/************************************************************************************************************
+* Private Functions Definitions
+ ************************************************************************************************************/
+
+static uint16_t __get_sample(void *user_context, ul_pm_sample_type_t sample_type, uint32_t index){
+	return (
+		sample_type == UL_PM_SAMPLE_TYPE_VOLTAGE ?
+		__v_samples[index] :
+		__i_samples[index]
+	);
+}
+
+/**
+ * @brief 230V/5A-ish mains with a 3rd harmonic on the current and some deterministic noise.
+ */
+static void __generate_window(){
+	uint32_t seed = 1;
+
+	for(uint32_t i=0; i<WINDOW_SAMPLES; i++){
+		double phase = 2 * M_PI * MAINS_FREQUENCY_HZ * i / SAMPLE_RATE_HZ;
+
+		seed = seed * 1103515245 + 12345;
+		int noise = (int) ((seed >> 16) % 9) - 4;
+
+		__v_samples[i] = 1920 + 1200 * sin(phase) + noise;
+		__i_samples[i] = 1920 + 400 * sin(phase - 0.5) + 80 * sin(3 * phase) + noise;
+
+		__raw_samples[2 * i] = (6 << 12) | __v_samples[i];
+		__raw_samples[2 * i + 1] = (7 << 12) | __i_samples[i];
+
+		__soa_samples[0][i] = __v_samples[i];
+		__soa_samples[1][i] = __i_samples[i];
+
+		// Smaller loads, each with its own phase.
+		for(uint8_t c=0; c<CIRCUITS; c++)
+			__soa_samples[2 + c][i] = 1920 + 100 * (c + 1) * sin(phase - 0.2 * c) + noise;
+	}
+}
+
+/**
+ * @brief A whole multi-channel window: voltage and main current through `ul_pm`, then every circuit.
+ * @note `res` gets the results of the first circuit.
+ */
+static void __evaluate_circuits(ul_pm_handle_t *pm_handle, ul_pm_circuits_t *circuits, const ul_pm_span_t *v_span, const ul_pm_span_t *i_span, ul_pm_results_t *res){
+	ul_pm_circuit_results_t circuits_res[CIRCUITS];
+	uint32_t feed_len, dropped_len;
+
+	ul_pm_stream_feed_span(pm_handle, __soa_samples, v_span, i_span, WINDOW_SAMPLES, &feed_len, &dropped_len);
+	ul_pm_circuits_feed(circuits, __soa_samples[0], __soa_samples[2], WINDOW_SAMPLES, feed_len, dropped_len);
+
+	ul_pm_stream_finalize(pm_handle, res);
+	ul_pm_circuits_finalize(circuits, circuits_res);
+
+	res->i_rms = circuits_res[0].i_rms;
+	res->p_w = circuits_res[0].p_w;
+	res->p_var = circuits_res[0].p_var;
+	res->p_pf = circuits_res[0].p_pf;
+}
+
+static uint64_t __now_ns(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/************************************************************************************************************
+* Main
+ ************************************************************************************************************/
+
+int main(int argc, char **argv){
+
+	uint32_t iterations = (argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_ITERATIONS);
+	if(iterations == 0)
+		iterations = DEFAULT_ITERATIONS;
+
+	// Same front-end as the firmware `__pm_code_setup()`.
+	ul_pm_init_t pm_init = {
+		.adc_vcc_v = 3,
+		.adc_value_at_adc_vcc = 3840,
+
+		.v_transformer_gain = 0.06136,
+		.v_divider_r1_ohm = 10000,
+		.v_divider_r2_ohm = 680,
+
+		.i_clamp_gain = 0.0005,
+		.i_clamp_resistor_ohm = 120,
+
+		.v_rms_threshold = 10,
+		.i_rms_threshold = 0.05,
+
+		.v_correction_factor = 0.98,
+		.i_correction_factor = 1.08,
+
+		.sample_rate_hz = SAMPLE_RATE_HZ,
+
+		#ifdef UL_CONFIG_PM_HARMONICS
+		.nominal_frequency_hz = MAINS_FREQUENCY_HZ,
+		#endif
+
+		#ifndef UL_CONFIG_PM_DOUBLE_BUFFER
+		.sample_callback = __get_sample
+		#endif
+	};
+
+	ul_pm_handle_t *pm_handle;
+	if(ul_pm_begin(&pm_init, &pm_handle) != UL_OK){
+		fprintf(stderr, "Error on `ul_pm_begin()`\n");
+		return EXIT_FAILURE;
+	}
+
+	__generate_window();
+	ul_pm_results_t res;
+
+	#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+	#define evaluate()	ul_pm_evaluate(pm_handle, __v_samples, __i_samples, WINDOW_SAMPLES, &res)
+	#else
+	#define evaluate()	ul_pm_evaluate(pm_handle, NULL, WINDOW_SAMPLES, &res)
+	#endif
+
+	ul_pm_span_t v_span = {
+		.offset_bytes = 0,
+		.stride_bytes = 2 * sizeof(uint16_t),
+		.shift = 0,
+		.mask = 0x0FFF
+	};
+
+	ul_pm_span_t i_span = v_span;
+	i_span.offset_bytes = sizeof(uint16_t);
+
+	printf("ul_pm [%s, %s]: %lu windows of %u samples\n", KERNEL_NAME, HARMONICS_NAME, (unsigned long) iterations, WINDOW_SAMPLES);
+
+	bench("ul_pm_evaluate()", evaluate());
+	bench("ul_pm_evaluate_span()", ul_pm_evaluate_span(pm_handle, __raw_samples, &v_span, &i_span, WINDOW_SAMPLES, &res));
+
+	// Struct-of-arrays layout: one row per channel.
+	ul_pm_circuits_t *circuits;
+	if(ul_pm_circuits_begin(pm_handle, CIRCUITS, &circuits) != UL_OK){
+		fprintf(stderr, "Error on `ul_pm_circuits_begin()`\n");
+		return EXIT_FAILURE;
+	}
+
+	ul_pm_span_t soa_v_span = {
+		.offset_bytes = 0,
+		.stride_bytes = sizeof(uint16_t),
+		.shift = 0,
+		.mask = 0x0FFF
+	};
+
+	ul_pm_span_t soa_i_span = soa_v_span;
+	soa_i_span.offset_bytes = sizeof(__soa_samples[0]);
+
+	bench(
+		"ul_pm_stream_feed_span() + ul_pm_circuits_feed() (" __str(CIRCUITS) " circuits)",
+		__evaluate_circuits(pm_handle, circuits, &soa_v_span, &soa_i_span, &res)
+	);
+
+	ul_pm_circuits_end(circuits);
+	ul_pm_end(pm_handle);
+	return EXIT_SUCCESS;
+}
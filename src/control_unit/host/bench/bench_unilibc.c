@@ -0,0 +1,473 @@
+/** @file bench_unilibc.c
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	UniLibC hot paths host benchmark (time and heap allocations per operation),
+ * 												with regression thresholds: returns `EXIT_FAILURE` if any of them is exceeded.
+ * 												Build it against `unilibc` and `unilibc_wall_terminal` to cover both copies,
+ * 												and against `unilibc_crc_table16` and `unilibc_crc_bitwise` to cover every CRC kernel.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+// Standard libraries.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+// UniLibC libraries.
+#include <ul_crc.h>
+#include <ul_master_slave.h>
+#include <ul_utils.h>
+
+// Not installed on the wall terminal.
+#ifndef HOST_BENCH_WALL_TERMINAL
+#include <ul_pm.h>
+#include <ul_linked_list.h>
+#endif
+
+/************************************************************************************************************
+* Private Defines
+************************************************************************************************************/
+
+#define DEFAULT_ITERATIONS	200000
+
+// Only the fastest round counts: the thresholds are tight, and a busy host only makes some rounds slower.
+#define BENCH_REPETITIONS	5
+
+// `ul_pm_evaluate()` windows are much longer than the other operations.
+#define PM_ITERATIONS_DIVIDER	1000
+
+#define PM_WINDOW_SAMPLES	4000
+#define PM_SAMPLE_RATE_HZ	20000
+
+// Typical RS-485 payload, wall terminals payload and a long one.
+#define SHORT_MESSAGE_LEN	16
+#define WALL_TERMINAL_MESSAGE_LEN	3
+#define LONG_MESSAGE_LEN	200
+
+#define LIST_LEN	100
+
+// CRC check string (see the "check" value of the CRC catalogues).
+#define CRC_CHECK_STRING	"123456789"
+#define CRC_CHECK_LEN			(sizeof(CRC_CHECK_STRING) - 1)
+
+#define CRC8_CHECK_VALUE	0xF4
+#define CRC16_CHECK_VALUE	0x4B37
+#define CRC32_CHECK_VALUE	0xCBF43926
+
+#define __str2(x)	#x
+#define __str(x)	__str2(x)
+
+/**
+ * Thresholds are about 2 times the time measured on a desktop x86-64 (`-O2`):
+ * scale them with `--ns-scale` on slower hosts. Allocations thresholds are exact.
+ */
+#define MAX_NS_PM_EVALUATE					90000
+#define MAX_NS_MS_ENCODE						30
+#define MAX_NS_MS_DECODE						30
+#define MAX_NS_MS_WALL_TERMINAL			10
+#define MAX_NS_LIST_ADD_DELETE			70
+#define MAX_NS_LIST_APPEND_DELETE		650
+#define MAX_NS_LIST_GET							150
+#define MAX_NS_LIST_SEARCH					450
+#define MAX_NS_UTILS_MAP						20
+#define MAX_NS_UTILS_FTOA						50
+
+// CRCs, for every kernel (the wall terminal uses the 16 entries lookup tables).
+#if !defined(UL_CONFIG_CRC_TABLE_SIZE)
+#define MAX_NS_CRC8_SHORT						360
+#define MAX_NS_CRC8_LONG						5200
+#define MAX_NS_CRC16_LONG						5600
+#define MAX_NS_CRC32_LONG						5600
+#elif UL_CONFIG_CRC_TABLE_SIZE == 16
+#define MAX_NS_CRC8_SHORT						150
+#define MAX_NS_CRC8_LONG						3200
+#define MAX_NS_CRC16_LONG						2800
+#define MAX_NS_CRC32_LONG						2800
+#else
+#define MAX_NS_CRC8_SHORT						32
+#define MAX_NS_CRC8_LONG						1000
+#define MAX_NS_CRC16_LONG						1200
+#define MAX_NS_CRC32_LONG						1200
+#endif
+
+/**
+ * @brief Run `statement` `iterations` times for `BENCH_REPETITIONS` rounds, then print and check
+ * the time per operation of the fastest round and the allocations per operation.
+ */
+#define bench(name, iterations, max_ns, max_allocs, statement){ \
+	for(uint32_t i=0; i<(iterations) / 100 + 1; i++) \
+		statement; \
+	\
+	uint32_t allocs = __allocs; \
+	double ns_per_op = INFINITY; \
+	\
+	for(uint8_t r=0; r<BENCH_REPETITIONS; r++){ \
+		uint64_t start_ns = __now_ns(); \
+		\
+		for(uint32_t i=0; i<(iterations); i++) \
+			statement; \
+		\
+		double round_ns_per_op = (double) (__now_ns() - start_ns) / (iterations); \
+		if(round_ns_per_op < ns_per_op) \
+			ns_per_op = round_ns_per_op; \
+	} \
+	\
+	double allocs_per_op = (double) (__allocs - allocs) / ((double) (iterations) * BENCH_REPETITIONS); \
+	\
+	__report(name, ns_per_op, allocs_per_op, (max_ns) * ns_scale, max_allocs); \
+}
+
+/************************************************************************************************************
+* Private Variables
+ ************************************************************************************************************/
+
+// Heap allocations counted by the `--wrap` linker shims.
+static volatile uint32_t __allocs = 0;
+
+// Results sink, so that no benchmarked call is optimized away.
+static volatile uint32_t __sink;
+
+static uint32_t __failures = 0;
+
+static uint8_t __message[LONG_MESSAGE_LEN];
+static uint8_t __encoded[2 * LONG_MESSAGE_LEN];
+static uint8_t __decoded[LONG_MESSAGE_LEN];
+
+#ifndef HOST_BENCH_WALL_TERMINAL
+static uint16_t __v_samples[PM_WINDOW_SAMPLES];
+static uint16_t __i_samples[PM_WINDOW_SAMPLES];
+#endif
+
+/************************************************************************************************************
+* Private Functions Definitions
+ ************************************************************************************************************/
+
+extern void *__real_malloc(size_t size);
+extern void *__real_calloc(size_t nmemb, size_t size);
+extern void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size){
+	__allocs++;
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size){
+	__allocs++;
+	return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size){
+	__allocs++;
+	return __real_realloc(ptr, size);
+}
+
+static uint64_t __now_ns(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void __report(const char *name, double ns_per_op, double allocs_per_op, double max_ns, double max_allocs){
+	bool passed = (ns_per_op <= max_ns && allocs_per_op <= max_allocs);
+
+	printf(
+		"  %-44s %12.1f %10.2f %12.0f %10.2f  %s\n",
+		name, ns_per_op, allocs_per_op, max_ns, max_allocs, (passed ? "ok" : "FAIL")
+	);
+
+	if(!passed)
+		__failures++;
+}
+
+/**
+ * @brief Bit by bit reference of the `ul_master_slave.h` encoding (LSb first, 7 bits per encoded byte).
+ */
+static void __ms_reference_encode(uint8_t *dest_buf, uint8_t *src_buf, uint32_t src_buf_size, bool master){
+	uint32_t dest_buf_size = (src_buf_size * 8 + 6) / 7;
+
+	memset(dest_buf, (master ? 0x80 : 0x00), dest_buf_size);
+
+	for(uint32_t bit_index=0; bit_index<src_buf_size * 8; bit_index++)
+		dest_buf[bit_index / 7] |= ((src_buf[bit_index / 8] >> (bit_index % 8)) & 0x01) << (bit_index % 7);
+}
+
+/**
+ * @brief Compare encoding and decoding of every length up to `LONG_MESSAGE_LEN` to `__ms_reference_encode()`.
+ * @return The number of mismatches.
+ */
+static uint32_t __ms_check(){
+	static uint8_t reference[2 * LONG_MESSAGE_LEN];
+	uint32_t mismatches = 0, encoded_len;
+
+	for(uint32_t len=1; len<=LONG_MESSAGE_LEN; len++)
+		for(uint8_t master=0; master<2; master++){
+			encoded_len = ul_ms_compute_encoded_size(len);
+
+			__ms_reference_encode(reference, __message, len, master);
+
+			if(master){
+				ul_ms_encode_master_message(__encoded, __message, len);
+				ul_ms_decode_master_message(__decoded, __encoded, encoded_len);
+			}
+
+			else {
+				ul_ms_encode_slave_message(__encoded, __message, len);
+				ul_ms_decode_slave_message(__decoded, __encoded, encoded_len);
+			}
+
+			if(
+				memcmp(__encoded, reference, encoded_len) != 0 ||
+				memcmp(__decoded, __message, ul_ms_compute_decoded_size(encoded_len)) != 0
+			)
+				mismatches++;
+		}
+
+	return mismatches;
+}
+
+/**
+ * @brief Check every CRC against its known answer on `CRC_CHECK_STRING`, and `ul_crc_*_update()`
+ * fed byte by byte against the one-shot CRC of every length up to `LONG_MESSAGE_LEN`.
+ * @return The number of mismatches.
+ */
+static uint32_t __crc_check(){
+	const uint8_t *check = (const uint8_t*) CRC_CHECK_STRING;
+	uint32_t mismatches = 0;
+
+	if(ul_crc_crc8(check, CRC_CHECK_LEN) != CRC8_CHECK_VALUE)
+		mismatches++;
+
+	#ifdef UL_CONFIG_CRC_CRC16_POLYNOMIAL
+	if(ul_crc_crc16(check, CRC_CHECK_LEN) != CRC16_CHECK_VALUE)
+		mismatches++;
+	#endif
+
+	#ifdef UL_CONFIG_CRC_CRC32_POLYNOMIAL
+	if(ul_crc_crc32(check, CRC_CHECK_LEN) != CRC32_CHECK_VALUE)
+		mismatches++;
+	#endif
+
+	for(uint32_t len=1; len<=LONG_MESSAGE_LEN; len++){
+		uint8_t crc8 = ul_crc_crc8_init();
+
+		for(uint32_t i=0; i<len; i++)
+			crc8 = ul_crc_crc8_update(crc8, &__message[i], 1);
+
+		if(ul_crc_crc8_final(crc8) != ul_crc_crc8(__message, len))
+			mismatches++;
+
+		#ifdef UL_CONFIG_CRC_CRC16_POLYNOMIAL
+		uint16_t crc16 = ul_crc_crc16_init();
+
+		for(uint32_t i=0; i<len; i++)
+			crc16 = ul_crc_crc16_update(crc16, &__message[i], 1);
+
+		if(ul_crc_crc16_final(crc16) != ul_crc_crc16(__message, len))
+			mismatches++;
+		#endif
+
+		#ifdef UL_CONFIG_CRC_CRC32_POLYNOMIAL
+		uint32_t crc32 = ul_crc_crc32_init();
+
+		for(uint32_t i=0; i<len; i++)
+			crc32 = ul_crc_crc32_update(crc32, &__message[i], 1);
+
+		if(ul_crc_crc32_final(crc32) != ul_crc_crc32(__message, len))
+			mismatches++;
+		#endif
+	}
+
+	return mismatches;
+}
+
+#ifndef HOST_BENCH_WALL_TERMINAL
+static uint16_t __get_sample(void *user_context, ul_pm_sample_type_t sample_type, uint32_t index){
+	return (
+		sample_type == UL_PM_SAMPLE_TYPE_VOLTAGE ?
+		__v_samples[index] :
+		__i_samples[index]
+	);
+}
+
+static bool __is_equal(void *user_context, uint32_t index, void *element){
+	return *(uint32_t*) element == *(uint32_t*) user_context;
+}
+#endif
+
+/************************************************************************************************************
+* Main
+ ************************************************************************************************************/
+
+int main(int argc, char **argv){
+
+	uint32_t iterations = DEFAULT_ITERATIONS;
+	double ns_scale = 1;
+
+	for(int k=1; k<argc; k++){
+		if(strcmp(argv[k], "--ns-scale") == 0 && k + 1 < argc)
+			ns_scale = strtod(argv[++k], NULL);
+
+		else
+			iterations = strtoul(argv[k], NULL, 10);
+	}
+
+	if(iterations < PM_ITERATIONS_DIVIDER || ns_scale <= 0){
+		fprintf(stderr, "Usage: %s [iterations >= %u] [--ns-scale X]\n", argv[0], PM_ITERATIONS_DIVIDER);
+		return EXIT_FAILURE;
+	}
+
+	for(uint32_t i=0; i<LONG_MESSAGE_LEN; i++)
+		__message[i] = i * 37 + 11;
+
+	printf("UniLibC: %lu iterations, thresholds x%.2f\n", (unsigned long) iterations, ns_scale);
+	printf("  %-44s %12s %10s %12s %10s\n", "", "ns/op", "allocs/op", "max ns/op", "max allocs");
+
+	/* ul_crc */
+
+	bench("ul_crc_crc8() " __str(SHORT_MESSAGE_LEN) "B", iterations, MAX_NS_CRC8_SHORT, 0, __sink = ul_crc_crc8(__message, SHORT_MESSAGE_LEN));
+	bench("ul_crc_crc8() " __str(LONG_MESSAGE_LEN) "B", iterations, MAX_NS_CRC8_LONG, 0, __sink = ul_crc_crc8(__message, LONG_MESSAGE_LEN));
+
+	#ifdef UL_CONFIG_CRC_CRC16_POLYNOMIAL
+	bench("ul_crc_crc16() " __str(LONG_MESSAGE_LEN) "B", iterations, MAX_NS_CRC16_LONG, 0, __sink = ul_crc_crc16(__message, LONG_MESSAGE_LEN));
+	#endif
+
+	#ifdef UL_CONFIG_CRC_CRC32_POLYNOMIAL
+	bench("ul_crc_crc32() " __str(LONG_MESSAGE_LEN) "B", iterations, MAX_NS_CRC32_LONG, 0, __sink = ul_crc_crc32(__message, LONG_MESSAGE_LEN));
+	#endif
+
+	uint32_t crc_mismatches = __crc_check();
+
+	if(crc_mismatches > 0){
+		printf("  ul_crc check value and byte by byte update: %lu mismatches, FAIL\n", (unsigned long) crc_mismatches);
+		__failures++;
+	}
+
+	/* ul_master_slave */
+
+	bench("ul_ms_encode_master_message() " __str(SHORT_MESSAGE_LEN) "B", iterations, MAX_NS_MS_ENCODE, 0, __sink = ul_ms_encode_master_message(__encoded, __message, SHORT_MESSAGE_LEN));
+	bench("ul_ms_decode_master_message() " __str(SHORT_MESSAGE_LEN) "B", iterations, MAX_NS_MS_DECODE, 0, __sink = ul_ms_decode_master_message(__decoded, __encoded, ul_ms_compute_encoded_size(SHORT_MESSAGE_LEN)));
+	bench("ul_ms_encode_slave_message() " __str(SHORT_MESSAGE_LEN) "B", iterations, MAX_NS_MS_ENCODE, 0, __sink = ul_ms_encode_slave_message(__encoded, __message, SHORT_MESSAGE_LEN));
+	bench("ul_ms_decode_slave_message() " __str(SHORT_MESSAGE_LEN) "B", iterations, MAX_NS_MS_DECODE, 0, __sink = ul_ms_decode_slave_message(__decoded, __encoded, ul_ms_compute_encoded_size(SHORT_MESSAGE_LEN)));
+
+	bench("ul_ms_encode_slave_message() " __str(WALL_TERMINAL_MESSAGE_LEN) "B", iterations, MAX_NS_MS_WALL_TERMINAL, 0, __sink = ul_ms_encode_slave_message(__encoded, __message, WALL_TERMINAL_MESSAGE_LEN));
+	bench("ul_ms_decode_slave_message() " __str(WALL_TERMINAL_MESSAGE_LEN) "B", iterations, MAX_NS_MS_WALL_TERMINAL, 0, __sink = ul_ms_decode_slave_message(__decoded, __encoded, ul_ms_compute_encoded_size(WALL_TERMINAL_MESSAGE_LEN)));
+
+	uint32_t ms_mismatches = __ms_check();
+
+	if(ms_mismatches > 0){
+		printf("  ul_ms round trip 1..." __str(LONG_MESSAGE_LEN) "B: %lu mismatches, FAIL\n", (unsigned long) ms_mismatches);
+		__failures++;
+	}
+
+	/* ul_utils */
+
+	char str[32];
+
+	bench("ul_utils_map_int()", iterations, MAX_NS_UTILS_MAP, 0, __sink = ul_utils_map_int(__sink & 0x3FF, 0, 1023, 0, 255));
+	bench("ul_utils_ftoa()", iterations, MAX_NS_UTILS_FTOA, 0, __sink = ul_utils_ftoa(-123.456f, str, 3)[0]);
+
+	#ifndef HOST_BENCH_WALL_TERMINAL
+
+	/* ul_linked_list */
+
+	ul_linked_list_handle_t *list;
+	uint32_t element = 0, index, key = LIST_LEN - 1;
+
+	if(ul_linked_list_begin(&(ul_linked_list_init_t){ .element_size = sizeof(uint32_t), .user_context = &key }, &list) != UL_OK){
+		fprintf(stderr, "Error on `ul_linked_list_begin()`\n");
+		return EXIT_FAILURE;
+	}
+
+	for(element=0; element<LIST_LEN; element++)
+		ul_linked_list_append(list, &element);
+
+	bench(
+		"ul_linked_list_add() + _delete(0)",
+		iterations, MAX_NS_LIST_ADD_DELETE, 2,
+		{ ul_linked_list_add(list, &element); ul_linked_list_delete(list, 0); }
+	);
+
+	bench(
+		"ul_linked_list_append() + _delete(" __str(LIST_LEN) ")",
+		iterations, MAX_NS_LIST_APPEND_DELETE, 2,
+		{ ul_linked_list_append(list, &element); ul_linked_list_delete(list, LIST_LEN); }
+	);
+
+	bench("ul_linked_list_get(" __str(LIST_LEN) " / 2)", iterations, MAX_NS_LIST_GET, 0, ul_linked_list_get(list, LIST_LEN / 2, &element));
+	bench("ul_linked_list_search() (last)", iterations, MAX_NS_LIST_SEARCH, 0, ul_linked_list_search(list, __is_equal, &index));
+
+	ul_linked_list_end(list);
+
+	/* ul_pm */
+
+	for(uint32_t i=0; i<PM_WINDOW_SAMPLES; i++){
+		double phase = 2 * M_PI * 50 * i / PM_SAMPLE_RATE_HZ;
+
+		__v_samples[i] = 1920 + 1200 * sin(phase);
+		__i_samples[i] = 1920 + 400 * sin(phase - 0.5) + 80 * sin(3 * phase);
+	}
+
+	// Same front-end as the firmware `__pm_code_setup()`.
+	ul_pm_init_t pm_init = {
+		.adc_vcc_v = 3,
+		.adc_value_at_adc_vcc = 3840,
+
+		.v_transformer_gain = 0.06136,
+		.v_divider_r1_ohm = 10000,
+		.v_divider_r2_ohm = 680,
+
+		.i_clamp_gain = 0.0005,
+		.i_clamp_resistor_ohm = 120,
+
+		.v_rms_threshold = 10,
+		.i_rms_threshold = 0.05,
+
+		.v_correction_factor = 0.98,
+		.i_correction_factor = 1.08,
+
+		.sample_rate_hz = PM_SAMPLE_RATE_HZ,
+
+		#ifdef UL_CONFIG_PM_HARMONICS
+		.nominal_frequency_hz = 50,
+		#endif
+
+		#ifndef UL_CONFIG_PM_DOUBLE_BUFFER
+		.sample_callback = __get_sample
+		#endif
+	};
+
+	ul_pm_handle_t *pm_handle;
+	ul_pm_results_t res;
+
+	if(ul_pm_begin(&pm_init, &pm_handle) != UL_OK){
+		fprintf(stderr, "Error on `ul_pm_begin()`\n");
+		return EXIT_FAILURE;
+	}
+
+	#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+	#define evaluate()	ul_pm_evaluate(pm_handle, __v_samples, __i_samples, PM_WINDOW_SAMPLES, &res)
+	#else
+	#define evaluate()	ul_pm_evaluate(pm_handle, NULL, PM_WINDOW_SAMPLES, &res)
+	#endif
+
+	bench("ul_pm_evaluate() " __str(PM_WINDOW_SAMPLES) " samples", iterations / PM_ITERATIONS_DIVIDER, MAX_NS_PM_EVALUATE, 0, __sink = evaluate());
+
+	ul_pm_end(pm_handle);
+
+	#endif
+
+	printf("%s: %lu thresholds exceeded\n", (__failures == 0 ? "PASS" : "FAIL"), (unsigned long) __failures);
+	return (__failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,51 @@
+/** @file ul_configs.h
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	Host build UniLibC configurations: the firmware ones plus the host overrides.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+#ifndef HOST_UL_CONFIGS_H_
+#define HOST_UL_CONFIGS_H_
+
+/************************************************************************************************************
+* Firmware configurations
+************************************************************************************************************/
+
+#include "../../components/unilibc/include/ul_configs.h"
+
+/************************************************************************************************************
+* Host overrides
+************************************************************************************************************/
+
+// No ESP-IDF on the host.
+#ifndef UL_CONFIG_ERRORS_DISABLE_ESP_IDF_SHIMS
+#define UL_CONFIG_ERRORS_DISABLE_ESP_IDF_SHIMS
+#endif
+
+// Set by the `*_float` targets to compare against the firmware fixed point kernel.
+#ifdef HOST_UL_CONFIG_PM_FLOAT
+#undef UL_CONFIG_PM_FIXED_POINT
+#endif
+
+// Set by the `*_no_harmonics` targets to measure the harmonic analysis cost.
+#ifdef HOST_UL_CONFIG_PM_NO_HARMONICS
+#undef UL_CONFIG_PM_HARMONICS
+#endif
+
+// Set by the `*_crc_table16` targets to check and measure the 16 entries CRC lookup tables.
+#ifdef HOST_UL_CONFIG_CRC_TABLE16
+#undef UL_CONFIG_CRC_TABLE_SIZE
+#define UL_CONFIG_CRC_TABLE_SIZE	16
+#endif
+
+// Set by the `*_crc_bitwise` targets to check and measure the bit by bit CRCs.
+#ifdef HOST_UL_CONFIG_CRC_BITWISE
+#undef UL_CONFIG_CRC_TABLE_SIZE
+#endif
+
+#endif  /* HOST_UL_CONFIGS_H_ */
@@ -0,0 +1,522 @@
+/** @file replay_pm.c
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	`ul_pm_evaluate()` replay of recorded or synthetic captures, window by window,
+ * 												with golden results check and throughput (samples per second).
+ * 												Returns `EXIT_FAILURE` if any window is over the tolerance.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+// Standard libraries.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+// UniLibC libraries.
+#include <ul_pm.h>
+
+/************************************************************************************************************
+* Private Defines
+************************************************************************************************************/
+
+// Same window as the firmware default (`CONFIG_PM_ADC_SAMPLES`).
+#define DEFAULT_WINDOW_SAMPLES	4000
+#define DEFAULT_TOLERANCE				0.001
+#define MAINS_FREQUENCY_HZ			50
+
+// Added to the relative tolerance, for the values close to 0.
+#define ABS_TOLERANCE	0.001
+
+// Firmware `pm_capture_header_t` magic string and version (see `pm.h`).
+#define PM_CAPTURE_MAGIC		"PMWF"
+#define PM_CAPTURE_VERSION	1
+
+// `--generate` capture: 2s @ 20kHz.
+#define GENERATE_SAMPLE_RATE_HZ	20000
+#define GENERATE_SAMPLES				40000
+
+#define GOLDEN_HEADER	"window,v_rms,i_rms,p_va,p_w,p_var,p_pf,frequency_hz"
+#define GOLDEN_FIELDS	7
+
+/************************************************************************************************************
+* Private Types Definitions
+ ************************************************************************************************************/
+
+// Firmware `pm_capture_header_t` (little-endian), followed by `pairs_len` pairs of `int16_t`.
+typedef struct __attribute__((__packed__)) {
+	char magic[4];
+	uint8_t version;
+	uint8_t bits;
+	uint8_t windows;
+	uint8_t truncated;
+	uint32_t sample_rate_hz;
+	uint32_t pairs_len;
+	float v_scale;
+	float i_scale;
+} capture_header_t;
+
+// Deinterleaved capture, in raw ADC units.
+typedef struct {
+	uint32_t sample_rate_hz;
+	uint32_t samples_len;
+	uint16_t *v;
+	uint16_t *i;
+} capture_t;
+
+// `ul_pm_sample_callback_t` context: the current window of the capture.
+typedef struct {
+	const uint16_t *v;
+	const uint16_t *i;
+} window_t;
+
+/************************************************************************************************************
+* Private Functions Definitions
+ ************************************************************************************************************/
+
+static uint64_t __now_ns(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#ifndef UL_CONFIG_PM_DOUBLE_BUFFER
+static uint16_t __get_sample(void *user_context, ul_pm_sample_type_t sample_type, uint32_t index){
+	window_t *window = (window_t*) user_context;
+
+	return (
+		sample_type == UL_PM_SAMPLE_TYPE_VOLTAGE ?
+		window->v[index] :
+		window->i[index]
+	);
+}
+#endif
+
+static void __usage(const char *name){
+	fprintf(
+		stderr,
+		"Usage: %s [options] <capture>\n"
+		"  <capture>            WAV (16-bit PCM, 2 channels: V, I), `/pm/capture` download or raw int16 (see --raw)\n"
+		"  --raw RATE           headerless capture of interleaved int16 V, I pairs at RATE Hz\n"
+		"  --offset N           added to every sample (e.g. 1920 for signed recordings); default 0\n"
+		"  --window N           samples per window; default %u\n"
+		"  --repeat N           replay the whole capture N times for the throughput; default 1\n"
+		"  --golden FILE        check every window against FILE (CSV)\n"
+		"  --tolerance X        relative tolerance of the golden check; default %g\n"
+		"  --write-golden FILE  write the results of every window to FILE (CSV)\n"
+		"  --generate FILE      write a synthetic WAV capture to FILE, then exit\n",
+		name, DEFAULT_WINDOW_SAMPLES, DEFAULT_TOLERANCE
+	);
+}
+
+static void __write_u16(FILE *file, uint16_t value){
+	fwrite(&value, sizeof(value), 1, file);
+}
+
+static void __write_u32(FILE *file, uint32_t value){
+	fwrite(&value, sizeof(value), 1, file);
+}
+
+/**
+ * @brief 230V/5A-ish mains at 49.8Hz with 3rd and 5th harmonics on the current and some deterministic noise.
+ */
+static int __generate(const char *path){
+	FILE *file = fopen(path, "wb");
+	uint32_t seed = 1;
+
+	if(file == NULL){
+		perror(path);
+		return EXIT_FAILURE;
+	}
+
+	uint32_t data_len = GENERATE_SAMPLES * 2 * sizeof(int16_t);
+
+	fwrite("RIFF", 1, 4, file);
+	__write_u32(file, 36 + data_len);
+	fwrite("WAVEfmt ", 1, 8, file);
+	__write_u32(file, 16);
+	__write_u16(file, 1);		// PCM.
+	__write_u16(file, 2);
+	__write_u32(file, GENERATE_SAMPLE_RATE_HZ);
+	__write_u32(file, GENERATE_SAMPLE_RATE_HZ * 2 * sizeof(int16_t));
+	__write_u16(file, 2 * sizeof(int16_t));
+	__write_u16(file, 16);
+	fwrite("data", 1, 4, file);
+	__write_u32(file, data_len);
+
+	for(uint32_t n=0; n<GENERATE_SAMPLES; n++){
+		double phase = 2 * M_PI * 49.8 * n / GENERATE_SAMPLE_RATE_HZ;
+
+		seed = seed * 1103515245 + 12345;
+		int noise = (int) ((seed >> 16) % 9) - 4;
+
+		__write_u16(file, 1920 + 1200 * sin(phase) + noise);
+		__write_u16(file, 1920 + 400 * sin(phase - 0.5) + 80 * sin(3 * phase) + 30 * sin(5 * phase + 1) + noise);
+	}
+
+	fclose(file);
+	printf("%s: %u pairs @ %uHz\n", path, GENERATE_SAMPLES, GENERATE_SAMPLE_RATE_HZ);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Find the sample rate and the data of a 16-bit stereo PCM WAV.
+ * @return `false` if `buffer` is not such a WAV.
+ */
+static bool __parse_wav(const uint8_t *buffer, size_t len, uint32_t *sample_rate_hz, size_t *data_offset, size_t *data_len){
+	uint16_t format = 0, channels = 0, bits = 0;
+	size_t offset = 12;
+	uint32_t chunk_len;
+
+	*sample_rate_hz = 0;
+
+	if(len < 12 || memcmp(buffer, "RIFF", 4) != 0 || memcmp(&buffer[8], "WAVE", 4) != 0)
+		return false;
+
+	while(offset + 8 <= len){
+		memcpy(&chunk_len, &buffer[offset + 4], sizeof(chunk_len));
+
+		if(memcmp(&buffer[offset], "fmt ", 4) == 0 && chunk_len >= 16){
+			memcpy(&format, &buffer[offset + 8], sizeof(format));
+			memcpy(&channels, &buffer[offset + 10], sizeof(channels));
+			memcpy(sample_rate_hz, &buffer[offset + 12], sizeof(*sample_rate_hz));
+			memcpy(&bits, &buffer[offset + 22], sizeof(bits));
+		}
+
+		else if(memcmp(&buffer[offset], "data", 4) == 0){
+			*data_offset = offset + 8;
+			*data_len = (chunk_len < len - *data_offset ? chunk_len : len - *data_offset);
+			return format == 1 && channels == 2 && bits == 16 && *sample_rate_hz > 0;
+		}
+
+		// Chunks are word aligned.
+		offset += 8 + chunk_len + (chunk_len & 1);
+	}
+
+	return false;
+}
+
+/**
+ * @brief Load a capture (WAV, `/pm/capture` download or raw) and deinterleave it.
+ * @param raw_rate_hz Sample rate of a raw capture, 0 if the capture has a header.
+ */
+static bool __load_capture(const char *path, uint32_t raw_rate_hz, int32_t sample_offset, capture_t *capture){
+	FILE *file = fopen(path, "rb");
+	uint8_t *buffer;
+	size_t len, data_offset = 0, data_len;
+	capture_header_t header;
+	int16_t sample;
+
+	if(file == NULL){
+		perror(path);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	len = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	buffer = malloc(len > 0 ? len : 1);
+	if(buffer == NULL || fread(buffer, 1, len, file) != len){
+		fprintf(stderr, "%s: read error\n", path);
+		fclose(file);
+		free(buffer);
+		return false;
+	}
+
+	fclose(file);
+	data_len = len;
+
+	if(raw_rate_hz > 0)
+		capture->sample_rate_hz = raw_rate_hz;
+
+	else if(len >= sizeof(header) && memcmp(buffer, PM_CAPTURE_MAGIC, 4) == 0){
+		memcpy(&header, buffer, sizeof(header));
+
+		if(header.version != PM_CAPTURE_VERSION){
+			fprintf(stderr, "%s: unsupported capture version %u\n", path, header.version);
+			free(buffer);
+			return false;
+		}
+
+		capture->sample_rate_hz = header.sample_rate_hz;
+		data_offset = sizeof(header);
+		data_len = header.pairs_len * 2 * sizeof(int16_t);
+
+		if(data_len > len - data_offset)
+			data_len = len - data_offset;
+	}
+
+	else if(!__parse_wav(buffer, len, &capture->sample_rate_hz, &data_offset, &data_len)){
+		fprintf(stderr, "%s: neither a 16-bit stereo PCM WAV nor a `/pm/capture` download (use --raw for raw captures)\n", path);
+		free(buffer);
+		return false;
+	}
+
+	capture->samples_len = data_len / (2 * sizeof(int16_t));
+	capture->v = malloc(capture->samples_len * sizeof(uint16_t) + 1);
+	capture->i = malloc(capture->samples_len * sizeof(uint16_t) + 1);
+
+	if(capture->v == NULL || capture->i == NULL){
+		fprintf(stderr, "Out of memory\n");
+		free(buffer);
+		return false;
+	}
+
+	// Little-endian, like every supported host.
+	for(uint32_t n=0; n<capture->samples_len; n++){
+		memcpy(&sample, &buffer[data_offset + 4 * n], sizeof(sample));
+		capture->v[n] = sample + sample_offset;
+
+		memcpy(&sample, &buffer[data_offset + 4 * n + 2], sizeof(sample));
+		capture->i[n] = sample + sample_offset;
+	}
+
+	free(buffer);
+	return true;
+}
+
+static void __write_golden_row(FILE *file, uint32_t window, ul_pm_results_t *res){
+	fprintf(
+		file, "%u,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+		window, res->v_rms, res->i_rms, res->p_va, res->p_w, res->p_var, res->p_pf, res->frequency_hz
+	);
+}
+
+/**
+ * @brief Compare the results of `window` against the next golden row.
+ * @return The number of fields over the tolerance.
+ */
+static uint32_t __check_golden_row(FILE *file, uint32_t window, ul_pm_results_t *res, double tolerance){
+	const char *names[GOLDEN_FIELDS] = { "v_rms", "i_rms", "p_va", "p_w", "p_var", "p_pf", "frequency_hz" };
+	float values[GOLDEN_FIELDS] = { res->v_rms, res->i_rms, res->p_va, res->p_w, res->p_var, res->p_pf, res->frequency_hz };
+	double golden[GOLDEN_FIELDS];
+	uint32_t golden_window, errors = 0;
+
+	if(
+		fscanf(
+			file, "%u,%lf,%lf,%lf,%lf,%lf,%lf,%lf\n",
+			&golden_window, &golden[0], &golden[1], &golden[2], &golden[3], &golden[4], &golden[5], &golden[6]
+		) != GOLDEN_FIELDS + 1 ||
+		golden_window != window
+	){
+		printf("  window %u: missing from the golden file\n", window);
+		return 1;
+	}
+
+	for(uint8_t k=0; k<GOLDEN_FIELDS; k++)
+		if(fabs(values[k] - golden[k]) > tolerance * fabs(golden[k]) + ABS_TOLERANCE){
+			printf("  window %u: %s=%.6f, golden %.6f\n", window, names[k], values[k], golden[k]);
+			errors++;
+		}
+
+	return errors;
+}
+
+/************************************************************************************************************
+* Main
+ ************************************************************************************************************/
+
+int main(int argc, char **argv){
+
+	const char *capture_path = NULL;
+	const char *golden_path = NULL;
+	const char *write_golden_path = NULL;
+
+	uint32_t raw_rate_hz = 0;
+	int32_t sample_offset = 0;
+	uint32_t window_samples = DEFAULT_WINDOW_SAMPLES;
+	uint32_t repeat = 1;
+	double tolerance = DEFAULT_TOLERANCE;
+
+	for(int k=1; k<argc; k++){
+		bool has_value = (k + 1 < argc);
+
+		if(strcmp(argv[k], "--generate") == 0 && has_value)
+			return __generate(argv[++k]);
+
+		else if(strcmp(argv[k], "--raw") == 0 && has_value)
+			raw_rate_hz = strtoul(argv[++k], NULL, 10);
+
+		else if(strcmp(argv[k], "--offset") == 0 && has_value)
+			sample_offset = strtol(argv[++k], NULL, 10);
+
+		else if(strcmp(argv[k], "--window") == 0 && has_value)
+			window_samples = strtoul(argv[++k], NULL, 10);
+
+		else if(strcmp(argv[k], "--repeat") == 0 && has_value)
+			repeat = strtoul(argv[++k], NULL, 10);
+
+		else if(strcmp(argv[k], "--golden") == 0 && has_value)
+			golden_path = argv[++k];
+
+		else if(strcmp(argv[k], "--tolerance") == 0 && has_value)
+			tolerance = strtod(argv[++k], NULL);
+
+		else if(strcmp(argv[k], "--write-golden") == 0 && has_value)
+			write_golden_path = argv[++k];
+
+		else if(argv[k][0] != '-' && capture_path == NULL)
+			capture_path = argv[k];
+
+		else {
+			__usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if(capture_path == NULL || window_samples == 0 || repeat == 0){
+		__usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	capture_t capture;
+	if(!__load_capture(capture_path, raw_rate_hz, sample_offset, &capture))
+		return EXIT_FAILURE;
+
+	uint32_t windows_len = capture.samples_len / window_samples;
+	if(windows_len == 0){
+		fprintf(stderr, "%s: shorter than a window (%u pairs)\n", capture_path, capture.samples_len);
+		return EXIT_FAILURE;
+	}
+
+	// Same front-end as the firmware `__pm_code_setup()`.
+	ul_pm_init_t pm_init = {
+		.adc_vcc_v = 3,
+		.adc_value_at_adc_vcc = 3840,
+
+		.v_transformer_gain = 0.06136,
+		.v_divider_r1_ohm = 10000,
+		.v_divider_r2_ohm = 680,
+
+		.i_clamp_gain = 0.0005,
+		.i_clamp_resistor_ohm = 120,
+
+		.v_rms_threshold = 10,
+		.i_rms_threshold = 0.05,
+
+		.v_correction_factor = 0.98,
+		.i_correction_factor = 1.08,
+
+		.sample_rate_hz = capture.sample_rate_hz,
+
+		#ifdef UL_CONFIG_PM_HARMONICS
+		.nominal_frequency_hz = MAINS_FREQUENCY_HZ,
+		#endif
+
+		#ifndef UL_CONFIG_PM_DOUBLE_BUFFER
+		.sample_callback = __get_sample
+		#endif
+	};
+
+	ul_pm_handle_t *pm_handle;
+	if(ul_pm_begin(&pm_init, &pm_handle) != UL_OK){
+		fprintf(stderr, "Error on `ul_pm_begin()`\n");
+		return EXIT_FAILURE;
+	}
+
+	FILE *golden = NULL, *write_golden = NULL;
+	char line[128];
+
+	if(golden_path != NULL){
+		golden = fopen(golden_path, "r");
+
+		// Header row.
+		if(golden == NULL || fgets(line, sizeof(line), golden) == NULL){
+			perror(golden_path);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if(write_golden_path != NULL){
+		write_golden = fopen(write_golden_path, "w");
+
+		if(write_golden == NULL){
+			perror(write_golden_path);
+			return EXIT_FAILURE;
+		}
+
+		fprintf(write_golden, GOLDEN_HEADER "\n");
+	}
+
+	printf(
+		"%s: %u pairs @ %uHz, %u windows of %u samples\n",
+		capture_path, capture.samples_len, capture.sample_rate_hz, windows_len, window_samples
+	);
+
+	ul_pm_results_t res;
+	window_t window;
+	uint32_t errors = 0;
+	uint64_t elapsed_ns = 0, start_ns;
+	double v_rms_sum = 0, i_rms_sum = 0, p_w_sum = 0;
+
+	for(uint32_t r=0; r<repeat; r++)
+		for(uint32_t w=0; w<windows_len; w++){
+			window.v = &capture.v[w * window_samples];
+			window.i = &capture.i[w * window_samples];
+
+			// Only `ul_pm` is timed.
+			start_ns = __now_ns();
+
+			#ifdef UL_CONFIG_PM_DOUBLE_BUFFER
+			ul_err_t ret = ul_pm_evaluate(pm_handle, (uint16_t*) window.v, (uint16_t*) window.i, window_samples, &res);
+			#else
+			ul_err_t ret = ul_pm_evaluate(pm_handle, &window, window_samples, &res);
+			#endif
+
+			elapsed_ns += __now_ns() - start_ns;
+
+			if(ret != UL_OK){
+				fprintf(stderr, "Error %d on `ul_pm_evaluate(window=%u)`\n", ret, w);
+				return EXIT_FAILURE;
+			}
+
+			// Outputs of the first pass only: every pass gives the same results.
+			if(r > 0)
+				continue;
+
+			v_rms_sum += res.v_rms;
+			i_rms_sum += res.i_rms;
+			p_w_sum += res.p_w;
+
+			if(write_golden != NULL)
+				__write_golden_row(write_golden, w, &res);
+
+			if(golden != NULL)
+				errors += __check_golden_row(golden, w, &res, tolerance);
+		}
+
+	printf("  mean V_rms=%.3f I_rms=%.4f P_w=%.3f\n", v_rms_sum / windows_len, i_rms_sum / windows_len, p_w_sum / windows_len);
+	printf(
+		"  %.1f Msamples/s (%.3f ns/sample)\n",
+		(double) repeat * windows_len * window_samples * 1e3 / elapsed_ns,
+		(double) elapsed_ns / ((double) repeat * windows_len * window_samples)
+	);
+
+	if(write_golden != NULL){
+		fclose(write_golden);
+		printf("  golden results written to %s\n", write_golden_path);
+	}
+
+	if(golden != NULL){
+		fclose(golden);
+		printf("  golden check: %s (%u errors)\n", errors == 0 ? "PASS" : "FAIL", errors);
+	}
+
+	ul_pm_end(pm_handle);
+	free(capture.v);
+	free(capture.i);
+
+	return (errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
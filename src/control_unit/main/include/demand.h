@@ -0,0 +1,116 @@
+/** @file demand.h
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	Sliding-window power demand, with daily and monthly peaks.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+#ifndef INC_DEMAND_H_
+#define INC_DEMAND_H_
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+// Standard libraries.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+// Platform libraries.
+#include <esp_err.h>
+#include <esp_check.h>
+#include <esp_log.h>
+#include <esp_netif_sntp.h>
+
+#include <freertos/FreeRTOS.h>
+
+// UniLibC libraries.
+#include <ul_errors.h>
+#include <ul_utils.h>
+
+// Project libraries.
+#include <main.h>
+#include <non_volatile_storage.h>
+
+/************************************************************************************************************
+* Public Defines
+************************************************************************************************************/
+
+/************************************************************************************************************
+* Public Types Definitions
+************************************************************************************************************/
+
+typedef struct __attribute__((__packed__)) {
+
+	// Highest sliding demand, and the Unix time of the end of its window (0 if none yet).
+	float p_w;
+	int64_t timestamp;
+
+} demand_peak_t;
+
+/**
+ * Peaks of the current day and month, and of the last complete month.
+ * Days and months are in `CONFIG_DEMAND_TIMEZONE`, as `YYYYMMDD` and `YYYYMM` (0 if unknown).
+ */
+typedef struct __attribute__((__packed__)) {
+
+	uint32_t day;
+	demand_peak_t day_peak;
+
+	uint32_t month;
+	demand_peak_t month_peak;
+
+	uint32_t last_month;
+	demand_peak_t last_month_peak;
+
+} demand_peaks_t;
+
+typedef struct {
+
+	// Average active power over the latest sliding window.
+	float p_w;
+
+	// The window is not full yet (e.g. after a reboot): `p_w` covers a shorter time and peaks are not tracked.
+	bool partial;
+
+	// The clock is synchronized: peaks are tracked.
+	bool clock_synced;
+
+	demand_peaks_t peaks;
+
+} demand_status_t;
+
+/************************************************************************************************************
+* Public Variables Prototypes
+************************************************************************************************************/
+
+/************************************************************************************************************
+* Public Functions Prototypes
+************************************************************************************************************/
+
+/**
+ * @brief Initialize the library, start the clock synchronization and restore the peaks from NVS.
+ */
+extern esp_err_t demand_setup();
+
+/**
+ * @brief Queue the active power of a PowerMonitor period (see `PM_RATE_MEDIUM`).
+ * @param duration_ms Period length, used as its weight.
+ * @note Never blocks: if the queue is full the period is dropped.
+ */
+extern esp_err_t demand_add_period(float p_w, uint32_t duration_ms);
+
+/**
+ * @brief Get the current demand and peaks.
+ */
+extern esp_err_t demand_get_status(demand_status_t *demand_status);
+
+#endif  /* INC_DEMAND_H_ */
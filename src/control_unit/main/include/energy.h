@@ -0,0 +1,92 @@
+/** @file energy.h
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	Energy counters (Wh/VArh) integrated from the PowerMonitor windows.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+#ifndef INC_ENERGY_H_
+#define INC_ENERGY_H_
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+// Standard libraries.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Platform libraries.
+#include <esp_err.h>
+#include <esp_check.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+
+// UniLibC libraries.
+#include <ul_errors.h>
+#include <ul_utils.h>
+#include <ul_pm.h>
+
+// Project libraries.
+#include <main.h>
+#include <non_volatile_storage.h>
+
+/************************************************************************************************************
+* Public Defines
+************************************************************************************************************/
+
+/************************************************************************************************************
+* Public Types Definitions
+************************************************************************************************************/
+
+typedef struct {
+
+	// Active energy drawn from (`p_w` > 0) and fed to (`p_w` < 0) the mains.
+	double wh_import;
+	double wh_export;
+
+	// Reactive energy.
+	double varh;
+
+} energy_counters_t;
+
+/************************************************************************************************************
+* Public Variables Prototypes
+************************************************************************************************************/
+
+/************************************************************************************************************
+* Public Functions Prototypes
+************************************************************************************************************/
+
+/**
+ * @brief Initialize the library and restore the counters from NVS.
+ */
+extern esp_err_t energy_setup();
+
+/**
+ * @brief Queue the powers of a PowerMonitor window to be integrated.
+ * @note Never blocks: if the queue is full the window is dropped and its time is charged to the next one.
+ */
+extern esp_err_t energy_add_window(ul_pm_results_t *ul_pm_results);
+
+/**
+ * @brief Get the current energy counters.
+ */
+extern esp_err_t energy_get_counters(energy_counters_t *energy_counters);
+
+/**
+ * @brief Reset the energy counters.
+ * @note The zeroed counters are saved to NVS on the next allowed checkpoint.
+ */
+extern esp_err_t energy_reset();
+
+#endif  /* INC_ENERGY_H_ */
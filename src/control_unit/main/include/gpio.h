@@ -66,4 +66,9 @@ extern esp_err_t gpio_setup();
  */
 extern esp_err_t gpio_write_zone(zone_t zone, uint8_t level);
 
+/**
+ * @brief Read the level last written to the mapped zone.
+ */
+extern esp_err_t gpio_read_zone(zone_t zone, uint8_t *level);
+
 #endif  /* INC_GPIO_H_ */
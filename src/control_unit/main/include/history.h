@@ -0,0 +1,123 @@
+/** @file history.h
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	In-RAM multi-resolution history of the PowerMonitor results.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+#ifndef INC_HISTORY_H_
+#define INC_HISTORY_H_
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+// Standard libraries.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+// Platform libraries.
+#include <esp_err.h>
+#include <esp_check.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+
+// UniLibC libraries.
+#include <ul_errors.h>
+#include <ul_utils.h>
+#include <ul_pm.h>
+
+// Project libraries.
+#include <main.h>
+
+/************************************************************************************************************
+* Public Defines
+************************************************************************************************************/
+
+// Number of resolution tiers (finest first).
+#define HISTORY_TIERS	3
+
+// Value of every field of a point without data.
+#define HISTORY_NO_DATA	INT16_MIN
+
+// Fixed-point scales of `history_point_t`.
+#define HISTORY_P_SCALE	1		// W
+#define HISTORY_V_SCALE	10	// 0.1V
+
+/************************************************************************************************************
+* Public Types Definitions
+************************************************************************************************************/
+
+typedef struct {
+
+	// Active power (1/`HISTORY_P_SCALE` W).
+	int16_t p_min;
+	int16_t p_avg;
+	int16_t p_max;
+
+	// RMS voltage (1/`HISTORY_V_SCALE` V).
+	int16_t v_min;
+	int16_t v_avg;
+	int16_t v_max;
+
+} history_point_t;
+
+typedef struct {
+
+	// Time covered by a point (seconds).
+	uint32_t period_s;
+
+	// Ring buffer capacity and number of stored points.
+	uint32_t len;
+	uint32_t count;
+
+	// Total points ever stored: the stored ones are [`pushed` - `count`, `pushed`).
+	uint32_t pushed;
+
+	// Uptime at the end of the newest stored point (seconds).
+	uint32_t end_s;
+
+} history_tier_info_t;
+
+/************************************************************************************************************
+* Public Variables Prototypes
+************************************************************************************************************/
+
+/************************************************************************************************************
+* Public Functions Prototypes
+************************************************************************************************************/
+
+/**
+ * @brief Initialize the library.
+ */
+extern esp_err_t history_setup();
+
+/**
+ * @brief Queue the results of a PowerMonitor window to be added to the history.
+ * @note Never blocks: if the queue is full the window is dropped.
+ */
+extern esp_err_t history_add_window(ul_pm_results_t *ul_pm_results);
+
+/**
+ * @brief Get the layout of the given tier (0 is the finest).
+ */
+extern esp_err_t history_get_tier_info(uint8_t tier, history_tier_info_t *history_tier_info);
+
+/**
+ * @brief Copy up to `*points_len` points of the given tier, starting from the absolute index `first`.
+ * @param points_len Buffer length in input, number of copied points in output.
+ * @note Points overwritten in the meantime are returned as `HISTORY_NO_DATA`, so the time axis never shifts.
+ */
+extern esp_err_t history_read(uint8_t tier, uint32_t first, history_point_t *points, uint32_t *points_len);
+
+#endif  /* INC_HISTORY_H_ */
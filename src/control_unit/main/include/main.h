@@ -38,6 +38,9 @@
 	micros() / 1000 \
 )
 
+// Any earlier Unix time means that the clock was never synchronized (2024-01-01).
+#define CLOCK_MIN_VALID_TIME	1704067200
+
 /************************************************************************************************************
 * Public Types Definitions
 ************************************************************************************************************/
@@ -72,4 +72,22 @@ extern bool nvs_available();
  */
 extern esp_err_t nvs_new_handle(nvs_handle_t *nvs_handle, const char *nvs_namespace);
 
+/**
+ * @brief Load a fixed size blob.
+ * @param nvs_namespace The relative NVS namespace.
+ * @param key The blob key.
+ * @param blob Where to store the blob; it is zeroed if the blob was never saved or on error.
+ * @param len The blob size in bytes: a stored blob of another size is rejected with `ESP_ERR_INVALID_SIZE`.
+ */
+extern esp_err_t nvs_load_blob(const char *nvs_namespace, const char *key, void *blob, size_t len);
+
+/**
+ * @brief Save and commit a fixed size blob.
+ * @param nvs_namespace The relative NVS namespace.
+ * @param key The blob key.
+ * @param blob The blob to save.
+ * @param len The blob size in bytes.
+ */
+extern esp_err_t nvs_save_blob(const char *nvs_namespace, const char *key, const void *blob, size_t len);
+
 #endif  /* INC_NON_VOLATILE_STORAGE_H_ */
@@ -31,6 +31,7 @@
 
 #include <freertos/FreeRTOS.h>
 #include <esp_adc/adc_continuous.h>
+#include <soc/soc_caps.h>
 
 // UniLibC libraries.
 #include <ul_errors.h>
@@ -40,15 +41,64 @@
 // Project libraries.
 #include <main.h>
 #include <gpio.h>
+#include <energy.h>
+#include <demand.h>
+#include <history.h>
+#include <shedding.h>
+#include <pq.h>
 
 /************************************************************************************************************
 * Public Defines
 ************************************************************************************************************/
 
+// Sub-metered circuits, on top of the main current clamp.
+#define PM_CIRCUITS	CONFIG_PM_CIRCUITS
+
+// `pm_capture_header_t` magic string and version.
+#define PM_CAPTURE_MAGIC		"PMWF"
+#define PM_CAPTURE_VERSION	1
+
 /************************************************************************************************************
 * Public Types Definitions
 ************************************************************************************************************/
 
+/**
+ * Slower rates of the PowerMonitor, on top of the windows and the mains cycles (the fast rate):
+ * each one is built by merging the partial sums of the faster one.
+ */
+typedef enum {
+	PM_RATE_MEDIUM = 0,		// CONFIG_PM_RATE_MEDIUM_PERIOD_MS.
+	PM_RATE_SLOW,					// CONFIG_PM_RATE_SLOW_PERIOD_S (demand interval).
+	PM_RATES
+} pm_rate_t;
+
+/**
+ * Raw waveform capture header (little-endian), followed by `pairs_len`
+ * pairs of `int16_t` raw ADC samples: voltage first, then current.
+ */
+typedef struct __attribute__((__packed__)) {
+
+	// `PM_CAPTURE_MAGIC` (without terminator) and `PM_CAPTURE_VERSION`.
+	char magic[4];
+	uint8_t version;
+
+	// ADC resolution (bits).
+	uint8_t bits;
+
+	// Captured windows and 1 if the capture buffer filled up before the last one.
+	uint8_t windows;
+	uint8_t truncated;
+
+	// Sample rate of each channel.
+	uint32_t sample_rate_hz;
+	uint32_t pairs_len;
+
+	// Volts and amps per ADC unit, once the DC offset (the mean) is removed.
+	float v_scale;
+	float i_scale;
+
+} pm_capture_header_t;
+
 /************************************************************************************************************
 * Public Variables Prototypes
 ************************************************************************************************************/
@@ -67,4 +117,35 @@ extern esp_err_t pm_setup();
  */
 extern esp_err_t pm_get_results(ul_pm_results_t *ul_pm_results);
 
+/**
+ * @brief Get the results of the latest mains cycle.
+ */
+extern esp_err_t pm_get_cycle_results(ul_pm_cycle_results_t *ul_pm_cycle_results);
+
+/**
+ * @brief Get the results of the latest complete period of `rate`.
+ * @note All zeros until the first period of `rate` ends.
+ */
+extern esp_err_t pm_get_rate_results(pm_rate_t rate, ul_pm_aggregate_results_t *ul_pm_aggregate_results);
+
+/**
+ * @brief Get the latest measurements of the sub-metered circuits.
+ * @param ul_pm_circuit_results Array of `PM_CIRCUITS` items.
+ * @return `ESP_ERR_NOT_SUPPORTED` if `PM_CIRCUITS` is 0.
+ */
+extern esp_err_t pm_get_circuits_results(ul_pm_circuit_results_t *ul_pm_circuit_results);
+
+/**
+ * @brief Capture the raw samples of the next `windows` measurement windows.
+ * @param header The capture header.
+ * @param samples Where to store the pointer to the captured samples, valid until `pm_capture_release()`.
+ * @note Only one capture at a time: on success, call `pm_capture_release()` when done with `samples`.
+ */
+extern esp_err_t pm_capture(uint8_t windows, pm_capture_header_t *header, int16_t **samples);
+
+/**
+ * @brief Release the capture obtained by `pm_capture()`.
+ */
+extern void pm_capture_release();
+
 #endif  /* INC_PM_H_ */
@@ -0,0 +1,167 @@
+/** @file pq.h
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	Power-quality event detector and recorder.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+#ifndef INC_PQ_H_
+#define INC_PQ_H_
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+// Standard libraries.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+// Platform libraries.
+#include <esp_err.h>
+#include <esp_check.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <freertos/FreeRTOS.h>
+
+// UniLibC libraries.
+#include <ul_errors.h>
+#include <ul_utils.h>
+
+// Project libraries.
+#include <main.h>
+#include <fs.h>
+
+/************************************************************************************************************
+* Public Defines
+************************************************************************************************************/
+
+// Raw DMA frames kept before and after the trigger of an event.
+#define PQ_SNAPSHOT_FRAMES	( \
+	CONFIG_PQ_PRE_TRIGGER_FRAMES + CONFIG_PQ_POST_TRIGGER_FRAMES \
+)
+
+// Events folder on VFS.
+#define PQ_EVENTS_FOLDER	FS_LITTLEFS_BASE_PATH "/pq"
+
+/************************************************************************************************************
+* Public Types Definitions
+************************************************************************************************************/
+
+typedef enum __attribute__((__packed__)) {
+	PQ_EVENT_TYPE_SAG = 0,
+	PQ_EVENT_TYPE_SWELL,
+	PQ_EVENT_TYPE_INTERRUPTION,
+	PQ_EVENT_TYPE_INRUSH
+} pq_event_type_t;
+
+typedef enum {
+	PQ_DETECT_NONE = 0,
+	PQ_DETECT_START,
+	PQ_DETECT_END
+} pq_detect_t;
+
+/**
+ * Event file header (little-endian), followed by `snapshot_len_bytes` bytes of raw
+ * `ADC_DIGI_OUTPUT_FORMAT_TYPE1` samples (`data:12`, `channel:4`) of every channel, in the ADC pattern
+ * order: voltage, current, then the sub-metered circuits currents (see `PM_CIRCUITS`).
+ */
+typedef struct __attribute__((__packed__)) {
+
+	// Increasing across reboots.
+	uint32_t id;
+	pq_event_type_t type;
+
+	/**
+	 * Wall-clock time (Unix time, ms) at the first abnormal cycle; 0 if the clock was not synchronized yet.
+	 * Events without it can still be ordered by `id`.
+	 */
+	int64_t timestamp_ms;
+
+	// Uptime at the first abnormal cycle, and event duration.
+	uint64_t uptime_ms;
+	uint32_t duration_ms;
+
+	// Lowest RMS voltage (sag, interruption), highest RMS voltage (swell) or highest RMS current (inrush).
+	float extreme;
+
+	// Snapshot layout: sample rate of each channel, V and A per ADC unit, and trigger position.
+	uint32_t sample_rate_hz;
+	float v_scale;
+	float i_scale;
+	uint32_t pre_trigger_bytes;
+	uint32_t snapshot_len_bytes;
+
+} pq_event_t;
+
+/**
+ * Ring of the latest raw DMA frames, owned by `pm.c`.
+ * It is frozen from the end of the post-trigger frames until `__pq_task` has saved it.
+ */
+typedef struct {
+	uint8_t *frames;
+	uint16_t frames_len[PQ_SNAPSHOT_FRAMES];
+	uint16_t frame_size_bytes;
+
+	// Oldest frame.
+	uint8_t head;
+
+	uint32_t sample_rate_hz;
+	float v_scale;
+	float i_scale;
+
+	// Cleared by `__pq_task` once saved.
+	volatile bool busy;
+} pq_snapshot_t;
+
+/************************************************************************************************************
+* Public Variables Prototypes
+************************************************************************************************************/
+
+/************************************************************************************************************
+* Public Functions Prototypes
+************************************************************************************************************/
+
+/**
+ * @brief Initialize the library.
+ */
+extern esp_err_t pq_setup();
+
+/**
+ * @brief Run the detector on the RMS values of a mains cycle (or of a window without cycles).
+ * @note Constant time, never blocks: called by `__pm_task`.
+ * @return Whether an event started or ended with this cycle. No event starts until the last one is submitted.
+ */
+extern pq_detect_t pq_detect(float v_rms, float i_rms);
+
+/**
+ * @brief Queue the last ended event to be saved, with its raw samples.
+ * @param snapshot Optional, can be `NULL`; it is marked busy until saved.
+ */
+extern esp_err_t pq_submit(pq_snapshot_t *snapshot);
+
+/**
+ * @brief Get the headers of the saved events.
+ * @param events_len Buffer length in input, number of events in output.
+ */
+extern esp_err_t pq_get_events(pq_event_t *events, uint32_t *events_len);
+
+/**
+ * @brief Open the file of the given event.
+ * @note Close it with `fclose()`.
+ */
+extern FILE *pq_open_event(uint32_t id);
+
+#endif  /* INC_PQ_H_ */
@@ -76,4 +76,9 @@ extern esp_err_t pwm_setup();
  */
 extern esp_err_t pwm_write_zone(uint8_t zone, uint16_t target_duty, uint16_t fade_time_ms);
 
+/**
+ * @brief Read the PWM duty target last written to the mapped zone.
+ */
+extern esp_err_t pwm_read_zone(uint8_t zone, uint16_t *target_duty);
+
 #endif  /* INC_PWM_H_ */
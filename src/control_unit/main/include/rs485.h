@@ -48,10 +48,45 @@
 * Public Defines
 ************************************************************************************************************/
 
+// Number of wall terminals on the RS-485 bus (from 1 to 32: one pending bit each on the "any news?" round).
+#define RS485_WALL_TERMINALS_COUNT	13
+
+// Telemetry histograms: bucket `i` counts the times within `2^(i+1)`us (the last bucket collects the overflows).
+#define RS485_TELEMETRY_HISTOGRAM_BUCKETS	20
+
 /************************************************************************************************************
 * Public Types Definitions
 ************************************************************************************************************/
 
+/**
+ * Bus counters of a wall terminal, since boot.
+ */
+typedef struct {
+	uint32_t polls;
+	uint32_t replies;
+
+	// Failed polls.
+	uint32_t timeouts;
+	uint32_t crc_errors;
+	uint32_t framing_errors;		// UART framing errors and overflows, wrong IDs, undecodable replies.
+
+	// From the poll to the complete reply.
+	uint32_t response_histogram[RS485_TELEMETRY_HISTOGRAM_BUCKETS];
+} rs485_wall_terminal_telemetry_t;
+
+typedef struct {
+
+	// "Any news?" rounds, and the ones garbled by a collision.
+	uint32_t rounds;
+	uint32_t garbled_rounds;
+
+	// Full scan: from an "any news?" round to the poll of the last wall terminal that raised its pending bit.
+	uint32_t cycle_histogram[RS485_TELEMETRY_HISTOGRAM_BUCKETS];
+
+	rs485_wall_terminal_telemetry_t wall_terminals[RS485_WALL_TERMINALS_COUNT];
+
+} rs485_telemetry_t;
+
 /************************************************************************************************************
 * Public Variables Prototypes
 ************************************************************************************************************/
@@ -65,4 +100,10 @@
  */
 extern esp_err_t rs485_setup();
 
+/**
+ * @brief Get a consistent copy of the bus telemetry.
+ * @note The rs485 task never waits for the caller.
+ */
+extern esp_err_t rs485_get_telemetry(rs485_telemetry_t *telemetry);
+
 #endif  /* INC_RS485_H_ */
@@ -0,0 +1,102 @@
+/** @file seqlock.h
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	Private sequence lock helpers: a single writer task never waits for
+ * 												its readers, and the sequence number is odd while a write is in progress.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+#ifndef INC_SEQLOCK_H_
+#define INC_SEQLOCK_H_
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+// Standard libraries.
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Platform libraries.
+#include <esp_err.h>
+
+// Project libraries.
+#include <main.h>
+
+/************************************************************************************************************
+* Public Defines
+************************************************************************************************************/
+
+/**
+ * `__seqlock_read()` attempts before giving up.
+ * After the first ones, every attempt waits a tick to let a preempted writer finish.
+ */
+#define SEQLOCK_READ_ATTEMPTS				10
+#define SEQLOCK_READ_SPIN_ATTEMPTS	3
+
+/************************************************************************************************************
+* Public Functions Definitions
+************************************************************************************************************/
+
+/**
+ * @brief Open an in-place write of the data guarded by `seq` (single writer).
+ */
+static inline void __seqlock_write_begin(volatile uint32_t *seq){
+
+	// Odd: write in progress.
+	*seq = *seq + 1;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Close the in-place write opened by `__seqlock_write_begin()`.
+ */
+static inline void __seqlock_write_end(volatile uint32_t *seq){
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	*seq = *seq + 1;
+}
+
+/**
+ * @brief Sequence lock write of `len` bytes from `src` to `dst` (single writer).
+ */
+static inline void __seqlock_write(volatile uint32_t *seq, void *dst, const void *src, size_t len){
+	__seqlock_write_begin(seq);
+	memcpy(dst, src, len);
+	__seqlock_write_end(seq);
+}
+
+/**
+ * @brief Sequence lock read of `len` bytes from `src` to `dst`: retried until no write overlaps it.
+ * @return `ESP_ERR_TIMEOUT` if every attempt overlapped a write.
+ */
+static inline esp_err_t __seqlock_read(volatile uint32_t *seq, void *dst, const void *src, size_t len){
+	uint32_t seq_begin;
+
+	for(uint8_t attempt=0; attempt<SEQLOCK_READ_ATTEMPTS; attempt++){
+
+		// The writer may be preempted by the caller on the same core: let it run.
+		if(attempt >= SEQLOCK_READ_SPIN_ATTEMPTS)
+			delay(1);
+
+		seq_begin = *seq;
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+		if(seq_begin & 1)
+			continue;
+
+		memcpy(dst, src, len);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+		if(*seq == seq_begin)
+			return ESP_OK;
+	}
+
+	return ESP_ERR_TIMEOUT;
+}
+
+#endif  /* INC_SEQLOCK_H_ */
@@ -0,0 +1,71 @@
+/** @file shedding.h
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * 					Description:	Priority-based load shedding driven by the PowerMonitor.
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+#ifndef INC_SHEDDING_H_
+#define INC_SHEDDING_H_
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+// Standard libraries.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Platform libraries.
+#include <esp_err.h>
+#include <esp_check.h>
+#include <esp_log.h>
+
+#include <freertos/FreeRTOS.h>
+
+// UniLibC libraries.
+#include <ul_errors.h>
+#include <ul_utils.h>
+#include <ul_pm.h>
+
+// Project libraries.
+#include <main.h>
+#include <zone.h>
+#include <gpio.h>
+#include <pwm.h>
+
+/************************************************************************************************************
+* Public Defines
+************************************************************************************************************/
+
+/************************************************************************************************************
+* Public Types Definitions
+************************************************************************************************************/
+
+/************************************************************************************************************
+* Public Variables Prototypes
+************************************************************************************************************/
+
+/************************************************************************************************************
+* Public Functions Prototypes
+************************************************************************************************************/
+
+/**
+ * @brief Initialize the library.
+ */
+extern esp_err_t shedding_setup();
+
+/**
+ * @brief Hand the results of a PowerMonitor window to the load shedding engine.
+ * @note Never blocks: only the latest window is kept.
+ */
+extern esp_err_t shedding_add_window(ul_pm_results_t *ul_pm_results);
+
+#endif  /* INC_SHEDDING_H_ */
@@ -47,6 +47,11 @@
 #include <wifi.h>
 #include <fs.h>
 #include <pm.h>
+#include <energy.h>
+#include <demand.h>
+#include <history.h>
+#include <pq.h>
+#include <rs485.h>
 
 /************************************************************************************************************
 * Public Defines
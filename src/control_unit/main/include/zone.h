@@ -147,6 +147,30 @@ typedef enum __attribute__((__packed__)) {
 	LEDC_CHANNEL_2 \
 }
 
+#define ZONE_SHEDDING_LEN	4
+
+/**
+ * Zones shed by `shedding.c` when the power budget is exceeded, by priority:
+ * the first one is shed first and restored last.
+ */
+#define ZONE_SHEDDING_ZONES	{ \
+	ZONE_RELAY_4, \
+	ZONE_RELAY_3, \
+	ZONE_LED_12, \
+	ZONE_LED_11 \
+}
+
+/**
+ * Corresponding duty (0 to `PWM_DUTY_MAX`) for `ZONE_SHEDDING_ZONES`:
+ * PWM zones are dimmed to it, digital zones are always switched off.
+ */
+#define ZONE_SHEDDING_DUTIES	{ \
+	0, \
+	0, \
+	256, \
+	256 \
+}
+
 /**
  * f: (device_id x button_id x button_state) -> (zone)
  *
@@ -0,0 +1,411 @@
+/** @file demand.c
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+#include <demand.h>
+#include <private.h>
+
+/************************************************************************************************************
+* Private Defines
+************************************************************************************************************/
+
+#define LOG_TAG	"demand"
+
+// `__demand_queue` max length in number of elements (periods of `PM_RATE_MEDIUM`).
+#define DEMAND_QUEUE_BUFFER_LEN_ELEMENTS	8
+
+// NVS namespace and key of the saved peaks.
+#define DEMAND_NVS_NAMESPACE	LOG_TAG
+#define DEMAND_NVS_KEY				"peaks"
+
+// The sliding window is as long as the slow rate period of the PowerMonitor.
+#define DEMAND_WINDOW_MS	((int64_t) CONFIG_PM_RATE_SLOW_PERIOD_S * 1000)
+#define DEMAND_BUCKET_MS	(DEMAND_WINDOW_MS / CONFIG_DEMAND_BUCKETS)
+
+#define DEMAND_NVS_MIN_INTERVAL_MS	((int64_t) CONFIG_DEMAND_NVS_MIN_INTERVAL_S * 1000)
+
+/**
+ * @brief Statement to check if the library was initialized.
+ */
+#define __is_initialized()( \
+	__demand_task_handle != NULL \
+)
+
+/************************************************************************************************************
+* Private Types Definitions
+ ************************************************************************************************************/
+
+typedef struct {
+	float p_w;
+	uint32_t duration_ms;
+} demand_period_t;
+
+typedef struct {
+
+	// Active energy (W*ms) and length of the bucket: integers, so the running sums never drift.
+	int64_t energy_wms;
+	int64_t duration_ms;
+
+} demand_bucket_t;
+
+/************************************************************************************************************
+* Private Variables
+ ************************************************************************************************************/
+
+static const char *TAG = LOG_TAG;
+
+static TaskHandle_t __demand_task_handle = NULL;
+static QueueHandle_t __demand_queue;
+
+// Status, shared with `demand_get_status()`.
+static demand_status_t __demand_status;
+static SemaphoreHandle_t __demand_mutex;
+
+// Ring of the complete buckets of the sliding window, private to `__demand_task`.
+static demand_bucket_t __demand_buckets[CONFIG_DEMAND_BUCKETS];
+static uint16_t __demand_buckets_head = 0;
+static uint16_t __demand_buckets_len = 0;
+
+// Sum of the buckets in the ring.
+static demand_bucket_t __demand_window;
+
+/************************************************************************************************************
+* Private Functions Prototypes
+ ************************************************************************************************************/
+
+static esp_err_t __sntp_setup();
+static esp_err_t __demand_task_setup();
+
+/**
+ * @brief Slide the window by one bucket, in constant time.
+ * @return The average active power over the window.
+ */
+static float __slide(demand_bucket_t *bucket);
+
+/**
+ * @brief Roll the day and the month of `peaks` over if needed, then update them with `p_w`.
+ * @return `true` if `peaks` changed.
+ */
+static bool __update_peaks(demand_peaks_t *peaks, float p_w, time_t now);
+
+static void __demand_task(void *parameters);
+
+/************************************************************************************************************
+* Private Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t __sntp_setup(){
+
+	esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(CONFIG_DEMAND_SNTP_SERVER);
+
+	ESP_RETURN_ON_ERROR(
+		esp_netif_sntp_init(&config),
+
+		TAG,
+		"Error on `esp_netif_sntp_init()`"
+	);
+
+	setenv("TZ", CONFIG_DEMAND_TIMEZONE, 1);
+	tzset();
+
+	return ESP_OK;
+}
+
+esp_err_t __demand_task_setup(){
+
+	__demand_mutex = xSemaphoreCreateMutex();
+	ESP_RETURN_ON_FALSE(
+		__demand_mutex != NULL,
+
+		ESP_ERR_NO_MEM,
+		TAG,
+		"Error: unable to allocate `__demand_mutex`"
+	);
+
+	__demand_queue = xQueueCreate(
+		DEMAND_QUEUE_BUFFER_LEN_ELEMENTS,
+		sizeof(demand_period_t)
+	);
+
+	ESP_RETURN_ON_FALSE(
+		__demand_queue != NULL,
+
+		ESP_ERR_NO_MEM,
+		TAG,
+		"Error: unable to allocate `__demand_queue`"
+	);
+
+	BaseType_t ret_val = xTaskCreatePinnedToCore(
+		__demand_task,
+		LOG_TAG "_task",
+		CONFIG_DEMAND_TASK_STACK_SIZE_BYTES,
+		NULL,
+		CONFIG_DEMAND_TASK_PRIORITY,
+		&__demand_task_handle,
+		CONFIG_DEMAND_TASK_CORE_AFFINITY
+	);
+
+	ESP_RETURN_ON_FALSE(
+		ret_val == pdPASS,
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error %d: unable to spawn \"" LOG_TAG "_task\"",
+		ret_val
+	);
+
+	return ESP_OK;
+}
+
+float __slide(demand_bucket_t *bucket){
+
+	demand_bucket_t *oldest;
+
+	// The oldest bucket leaves the window.
+	if(__demand_buckets_len == CONFIG_DEMAND_BUCKETS){
+		oldest = &__demand_buckets[__demand_buckets_head];
+
+		__demand_window.energy_wms -= oldest->energy_wms;
+		__demand_window.duration_ms -= oldest->duration_ms;
+
+		__demand_buckets_head = (__demand_buckets_head + 1) % CONFIG_DEMAND_BUCKETS;
+		__demand_buckets_len--;
+	}
+
+	__demand_buckets[(__demand_buckets_head + __demand_buckets_len) % CONFIG_DEMAND_BUCKETS] = *bucket;
+	__demand_buckets_len++;
+
+	__demand_window.energy_wms += bucket->energy_wms;
+	__demand_window.duration_ms += bucket->duration_ms;
+
+	return (float) __demand_window.energy_wms / __demand_window.duration_ms;
+}
+
+bool __update_peaks(demand_peaks_t *peaks, float p_w, time_t now){
+
+	struct tm tm;
+	uint32_t day, month;
+	bool changed = false;
+
+	localtime_r(&now, &tm);
+	day = (tm.tm_year + 1900) * 10000 + (tm.tm_mon + 1) * 100 + tm.tm_mday;
+	month = day / 100;
+
+	if(month != peaks->month){
+
+		// Kept for the contract check of the past month.
+		if(peaks->month != 0){
+			peaks->last_month = peaks->month;
+			peaks->last_month_peak = peaks->month_peak;
+		}
+
+		peaks->month = month;
+		peaks->month_peak = (demand_peak_t){ 0 };
+		changed = true;
+	}
+
+	if(day != peaks->day){
+		peaks->day = day;
+		peaks->day_peak = (demand_peak_t){ 0 };
+		changed = true;
+	}
+
+	if(peaks->day_peak.timestamp == 0 || p_w > peaks->day_peak.p_w){
+		peaks->day_peak = (demand_peak_t){
+			.p_w = p_w,
+			.timestamp = now
+		};
+
+		changed = true;
+	}
+
+	if(peaks->month_peak.timestamp == 0 || p_w > peaks->month_peak.p_w){
+		peaks->month_peak = peaks->day_peak;
+		changed = true;
+	}
+
+	return changed;
+}
+
+void __demand_task(void *parameters){
+
+	ESP_LOGI(TAG, "Started");
+
+	/* Variables */
+
+	// `ESP_GOTO_ON_ERROR()` return code.
+	esp_err_t ret __attribute__((unused));
+
+	// Incoming period and bucket being filled.
+	demand_period_t period;
+	demand_bucket_t bucket = { 0 };
+
+	float p_w;
+	bool partial;
+	bool clock_synced;
+	time_t now;
+
+	demand_peaks_t peaks;
+	bool peaks_changed;
+
+	/**
+	 * The first checkpoint is allowed only after a whole interval:
+	 * a boot loop can never write more often than `DEMAND_NVS_MIN_INTERVAL_MS`.
+	 */
+	int64_t last_checkpoint_ms = millis();
+	bool checkpoint_pending = false;
+
+	/* Code */
+
+	/* Infinite loop */
+	for(;;){
+		ret = ESP_OK;
+
+		// Waiting for `demand_add_period()`; wake up anyway to honour pending checkpoints.
+		if(xQueueReceive(__demand_queue, &period, pdMS_TO_TICKS(DEMAND_NVS_MIN_INTERVAL_MS)) == pdTRUE){
+
+			bucket.energy_wms += (int64_t) (period.p_w * period.duration_ms);
+			bucket.duration_ms += period.duration_ms;
+
+			if(bucket.duration_ms >= DEMAND_BUCKET_MS){
+				p_w = __slide(&bucket);
+				bucket = (demand_bucket_t){ 0 };
+
+				partial = (__demand_buckets_len < CONFIG_DEMAND_BUCKETS);
+
+				now = time(NULL);
+				clock_synced = (now >= CLOCK_MIN_VALID_TIME);
+
+				xSemaphoreTake(__demand_mutex, portMAX_DELAY);
+
+				__demand_status.p_w = p_w;
+				__demand_status.partial = partial;
+				__demand_status.clock_synced = clock_synced;
+
+				// A partial window would underestimate the demand right after a reboot.
+				peaks_changed = (
+					!partial && clock_synced &&
+					__update_peaks(&__demand_status.peaks, p_w, now)
+				);
+
+				xSemaphoreGive(__demand_mutex);
+
+				if(peaks_changed)
+					checkpoint_pending = true;
+			}
+		}
+
+		/* Write-behind checkpoint */
+
+		if(!checkpoint_pending || millis() - last_checkpoint_ms < DEMAND_NVS_MIN_INTERVAL_MS)
+			continue;
+
+		xSemaphoreTake(__demand_mutex, portMAX_DELAY);
+		peaks = __demand_status.peaks;
+		xSemaphoreGive(__demand_mutex);
+
+		// A failed write is retried on the next interval, never earlier.
+		last_checkpoint_ms = millis();
+
+		ESP_GOTO_ON_ERROR(
+			nvs_save_blob(
+				DEMAND_NVS_NAMESPACE,
+				DEMAND_NVS_KEY,
+				&peaks,
+				sizeof(demand_peaks_t)
+			),
+
+			task_continue,
+			TAG,
+			"Error on `nvs_save_blob()`"
+		);
+
+		checkpoint_pending = false;
+
+		task_continue:
+	}
+}
+
+/************************************************************************************************************
+* Public Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t demand_setup(){
+
+	__demand_status.partial = true;
+
+	if(!nvs_available())
+		ESP_LOGW(TAG, "NVS not available: peaks will not be saved");
+
+	else
+		ESP_ERROR_CHECK_WITHOUT_ABORT(
+			nvs_load_blob(
+				DEMAND_NVS_NAMESPACE,
+				DEMAND_NVS_KEY,
+				&__demand_status.peaks,
+				sizeof(demand_peaks_t)
+			)
+		);
+
+	ESP_LOGI(
+		TAG, "Peaks: %.0fW on %lu, %.0fW in %lu",
+		__demand_status.peaks.day_peak.p_w, __demand_status.peaks.day,
+		__demand_status.peaks.month_peak.p_w, __demand_status.peaks.month
+	);
+
+	// Without a synchronized clock only the current demand is available.
+	ESP_ERROR_CHECK_WITHOUT_ABORT(__sntp_setup());
+
+	ESP_RETURN_ON_ERROR(
+		__demand_task_setup(),
+
+		TAG,
+		"Error on `__demand_task_setup()`"
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t demand_add_period(float p_w, uint32_t duration_ms){
+
+	// Called by `__pm_task` on every period: no logs here.
+	if(!__is_initialized())
+		return ESP_ERR_INVALID_STATE;
+
+	demand_period_t period = {
+		.p_w = p_w,
+		.duration_ms = duration_ms
+	};
+
+	if(xQueueSend(__demand_queue, &period, 0) != pdTRUE)
+		return ESP_ERR_NO_MEM;
+
+	return ESP_OK;
+}
+
+esp_err_t demand_get_status(demand_status_t *demand_status){
+	assert_param_notnull(demand_status);
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	xSemaphoreTake(__demand_mutex, portMAX_DELAY);
+	*demand_status = __demand_status;
+	xSemaphoreGive(__demand_mutex);
+
+	return ESP_OK;
+}
@@ -0,0 +1,342 @@
+/** @file energy.c
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+#include <energy.h>
+#include <private.h>
+
+/************************************************************************************************************
+* Private Defines
+************************************************************************************************************/
+
+#define LOG_TAG	"energy"
+// #define LOG_CHECKPOINTS
+
+// `__energy_queue` max length in number of elements (~0.8s of 2-cycle windows @ 50Hz).
+#define ENERGY_QUEUE_BUFFER_LEN_ELEMENTS	20
+
+// NVS namespace and key of the saved counters.
+#define ENERGY_NVS_NAMESPACE	LOG_TAG
+#define ENERGY_NVS_KEY				"counters"
+
+/**
+ * Minimum time between two NVS writes, so that there are
+ * never more than `CONFIG_ENERGY_NVS_MAX_WRITES_PER_DAY` writes per day.
+ */
+#define ENERGY_CHECKPOINT_INTERVAL_MS	( \
+	(24 * 3600 * 1000) / CONFIG_ENERGY_NVS_MAX_WRITES_PER_DAY \
+)
+
+/**
+ * Longest time a single window can account for.
+ * If `__pm_task` stalls for longer, the gap is not charged with the power of the next window.
+ */
+#define ENERGY_MAX_WINDOW_GAP_US	1000000
+
+#define US_PER_HOUR	3600e6
+
+/**
+ * @brief Statement to check if the library was initialized.
+ */
+#define __is_initialized()( \
+	__energy_task_handle != NULL \
+)
+
+/************************************************************************************************************
+* Private Types Definitions
+ ************************************************************************************************************/
+
+typedef struct {
+
+	// Average powers of the window.
+	float p_w;
+	float p_var;
+
+	// End of the window (`micros()`).
+	int64_t timestamp_us;
+
+} energy_window_t;
+
+/************************************************************************************************************
+* Private Variables
+ ************************************************************************************************************/
+
+static const char *TAG = LOG_TAG;
+
+static TaskHandle_t __energy_task_handle = NULL;
+static QueueHandle_t __energy_queue;
+
+// Counters, shared with `energy_get_counters()` and `energy_reset()`.
+static energy_counters_t __energy_counters;
+static SemaphoreHandle_t __energy_mutex;
+
+// Set by `energy_reset()`: the next checkpoint is written even if the counters did not change enough.
+static bool __energy_reset_pending = false;
+
+/************************************************************************************************************
+* Private Functions Prototypes
+ ************************************************************************************************************/
+
+static esp_err_t __energy_task_setup();
+
+static void __energy_task(void *parameters);
+
+/************************************************************************************************************
+* Private Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t __energy_task_setup(){
+
+	__energy_mutex = xSemaphoreCreateMutex();
+	ESP_RETURN_ON_FALSE(
+		__energy_mutex != NULL,
+
+		ESP_ERR_NO_MEM,
+		TAG,
+		"Error: unable to allocate `__energy_mutex`"
+	);
+
+	__energy_queue = xQueueCreate(
+		ENERGY_QUEUE_BUFFER_LEN_ELEMENTS,
+		sizeof(energy_window_t)
+	);
+
+	ESP_RETURN_ON_FALSE(
+		__energy_queue != NULL,
+
+		ESP_ERR_NO_MEM,
+		TAG,
+		"Error: unable to allocate `__energy_queue`"
+	);
+
+	BaseType_t ret_val = xTaskCreatePinnedToCore(
+		__energy_task,
+		LOG_TAG "_task",
+		CONFIG_ENERGY_TASK_STACK_SIZE_BYTES,
+		NULL,
+		CONFIG_ENERGY_TASK_PRIORITY,
+		&__energy_task_handle,
+		CONFIG_ENERGY_TASK_CORE_AFFINITY
+	);
+
+	ESP_RETURN_ON_FALSE(
+		ret_val == pdPASS,
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error %d: unable to spawn \"" LOG_TAG "_task\"",
+		ret_val
+	);
+
+	return ESP_OK;
+}
+
+void __energy_task(void *parameters){
+
+	ESP_LOGI(TAG, "Started");
+
+	/* Variables */
+
+	// `ESP_GOTO_ON_ERROR()` return code.
+	esp_err_t ret __attribute__((unused));
+
+	// Incoming window.
+	energy_window_t window;
+
+	// End of the previous window (0 if there is none yet).
+	int64_t last_timestamp_us = 0;
+	int64_t elapsed_us;
+	double hours;
+
+	// Counters as they were on the last checkpoint.
+	energy_counters_t saved_counters = __energy_counters;
+	energy_counters_t counters;
+	double delta_wh;
+
+	/**
+	 * The first checkpoint is allowed only after a whole interval:
+	 * a boot loop can never write more often than `ENERGY_CHECKPOINT_INTERVAL_MS`.
+	 */
+	int64_t last_checkpoint_ms = millis();
+	bool checkpoint_pending = false;
+
+	/* Code */
+
+	/* Infinite loop */
+	for(;;){
+		ret = ESP_OK;
+
+		// Waiting for `energy_add_window()`; wake up anyway to honour pending checkpoints.
+		if(xQueueReceive(__energy_queue, &window, pdMS_TO_TICKS(ENERGY_CHECKPOINT_INTERVAL_MS)) == pdTRUE){
+
+			elapsed_us = (
+				last_timestamp_us == 0 ?
+				0 : window.timestamp_us - last_timestamp_us
+			);
+
+			last_timestamp_us = window.timestamp_us;
+
+			if(elapsed_us > ENERGY_MAX_WINDOW_GAP_US)
+				elapsed_us = ENERGY_MAX_WINDOW_GAP_US;
+
+			hours = elapsed_us / US_PER_HOUR;
+
+			xSemaphoreTake(__energy_mutex, portMAX_DELAY);
+
+			if(window.p_w >= 0)
+				__energy_counters.wh_import += window.p_w * hours;
+
+			else
+				__energy_counters.wh_export -= window.p_w * hours;
+
+			__energy_counters.varh += window.p_var * hours;
+			xSemaphoreGive(__energy_mutex);
+		}
+
+		/* Write-behind checkpoint */
+
+		if(millis() - last_checkpoint_ms < ENERGY_CHECKPOINT_INTERVAL_MS)
+			continue;
+
+		xSemaphoreTake(__energy_mutex, portMAX_DELAY);
+		counters = __energy_counters;
+		checkpoint_pending |= __energy_reset_pending;
+		__energy_reset_pending = false;
+		xSemaphoreGive(__energy_mutex);
+
+		delta_wh = (
+			(counters.wh_import - saved_counters.wh_import) +
+			(counters.wh_export - saved_counters.wh_export)
+		);
+
+		// Nothing worth a flash write.
+		if(!checkpoint_pending && delta_wh < CONFIG_ENERGY_NVS_MIN_DELTA_WH)
+			continue;
+
+		// A failed write is retried on the next interval, never earlier.
+		last_checkpoint_ms = millis();
+
+		ESP_GOTO_ON_ERROR(
+			nvs_save_blob(
+				ENERGY_NVS_NAMESPACE,
+				ENERGY_NVS_KEY,
+				&counters,
+				sizeof(energy_counters_t)
+			),
+
+			task_continue,
+			TAG,
+			"Error on `nvs_save_blob()`"
+		);
+
+		saved_counters = counters;
+		checkpoint_pending = false;
+
+		#ifdef LOG_CHECKPOINTS
+		ESP_LOGI(
+			TAG, "Checkpoint: %.1fWh import, %.1fWh export, %.1fVArh",
+			counters.wh_import, counters.wh_export, counters.varh
+		);
+		#endif
+
+		task_continue:
+	}
+}
+
+/************************************************************************************************************
+* Public Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t energy_setup(){
+
+	if(!nvs_available())
+		ESP_LOGW(TAG, "NVS not available: counters will not be saved");
+
+	else
+		ESP_ERROR_CHECK_WITHOUT_ABORT(
+			nvs_load_blob(
+				ENERGY_NVS_NAMESPACE,
+				ENERGY_NVS_KEY,
+				&__energy_counters,
+				sizeof(energy_counters_t)
+			)
+		);
+
+	ESP_LOGI(
+		TAG, "Counters: %.1fWh import, %.1fWh export, %.1fVArh",
+		__energy_counters.wh_import, __energy_counters.wh_export, __energy_counters.varh
+	);
+
+	ESP_RETURN_ON_ERROR(
+		__energy_task_setup(),
+
+		TAG,
+		"Error on `__energy_task_setup()`"
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t energy_add_window(ul_pm_results_t *ul_pm_results){
+
+	// Called by `__pm_task` on every window: no logs here.
+	if(!__is_initialized() || ul_pm_results == NULL)
+		return ESP_ERR_INVALID_STATE;
+
+	energy_window_t window = {
+		.p_w = ul_pm_results->p_w,
+		.p_var = ul_pm_results->p_var,
+		.timestamp_us = micros()
+	};
+
+	if(xQueueSend(__energy_queue, &window, 0) != pdTRUE)
+		return ESP_ERR_NO_MEM;
+
+	return ESP_OK;
+}
+
+esp_err_t energy_get_counters(energy_counters_t *energy_counters){
+	assert_param_notnull(energy_counters);
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	xSemaphoreTake(__energy_mutex, portMAX_DELAY);
+	*energy_counters = __energy_counters;
+	xSemaphoreGive(__energy_mutex);
+
+	return ESP_OK;
+}
+
+esp_err_t energy_reset(){
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	xSemaphoreTake(__energy_mutex, portMAX_DELAY);
+	__energy_counters = (energy_counters_t){ 0 };
+	__energy_reset_pending = true;
+	xSemaphoreGive(__energy_mutex);
+
+	ESP_LOGI(TAG, "Counters reset");
+	return ESP_OK;
+}
@@ -36,6 +36,13 @@
 static const char *TAG = LOG_TAG;
 static bool __is_initialized = false;
 
+/**
+ * Levels last written by `gpio_write_zone()`, by GPIO number.
+ * Written by the rs485, shedding and pm tasks, possibly from both cores: only accessed within `__gpio_levels_mux`.
+ */
+static uint64_t __gpio_levels = 0;
+static portMUX_TYPE __gpio_levels_mux = portMUX_INITIALIZER_UNLOCKED;
+
 /************************************************************************************************************
 * Private Functions Prototypes
  ************************************************************************************************************/
@@ -124,5 +131,38 @@ esp_err_t gpio_write_zone(zone_t zone, uint8_t level){
 		digital_gpio, level
 	);
 
+	taskENTER_CRITICAL(&__gpio_levels_mux);
+
+	if(level)
+		__gpio_levels |= __gpio_to_bit_mask(digital_gpio);
+
+	else
+		__gpio_levels &= ~__gpio_to_bit_mask(digital_gpio);
+
+	taskEXIT_CRITICAL(&__gpio_levels_mux);
+
+	return ESP_OK;
+}
+
+esp_err_t gpio_read_zone(zone_t zone, uint8_t *level){
+	assert_param_notnull(level);
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized,
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	int8_t digital_gpio = __zone_to_digital_gpio(zone);
+
+	// The zone is is not a digital zone.
+	if(digital_gpio == -1)
+		return ESP_ERR_NOT_SUPPORTED;
+
+	taskENTER_CRITICAL(&__gpio_levels_mux);
+	*level = ((__gpio_levels & __gpio_to_bit_mask(digital_gpio)) != 0);
+	taskEXIT_CRITICAL(&__gpio_levels_mux);
 	return ESP_OK;
 }
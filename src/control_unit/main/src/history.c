@@ -0,0 +1,491 @@
+/** @file history.c
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+#include <history.h>
+#include <private.h>
+
+/************************************************************************************************************
+* Private Defines
+************************************************************************************************************/
+
+#define LOG_TAG	"history"
+
+// `__history_queue` max length in number of elements.
+#define HISTORY_QUEUE_BUFFER_LEN_ELEMENTS	20
+
+// Tier configurations: point period (s) and ring buffer length (points).
+#define HISTORY_TIER_PERIODS_S	{ \
+	CONFIG_HISTORY_TIER_1_PERIOD_S, \
+	CONFIG_HISTORY_TIER_2_PERIOD_S, \
+	CONFIG_HISTORY_TIER_3_PERIOD_S \
+}
+
+#define HISTORY_TIER_LENS	{ \
+	CONFIG_HISTORY_TIER_1_LEN, \
+	CONFIG_HISTORY_TIER_2_LEN, \
+	CONFIG_HISTORY_TIER_3_LEN \
+}
+
+/**
+ * Struct-of-arrays ring buffers: every field of `history_point_t`
+ * has its own array of `len` elements on the tier allocation.
+ */
+#define HISTORY_FIELDS	(sizeof(history_point_t) / sizeof(int16_t))
+
+/**
+ * @brief Field `field` of the ring buffer element `i` of `tier`.
+ */
+#define __tier_field(tier, field, i) \
+	(tier)->data[(field) * (tier)->len + (i)]
+
+/**
+ * @brief Statement to check if the library was initialized.
+ */
+#define __is_initialized()( \
+	__history_task_handle != NULL \
+)
+
+/************************************************************************************************************
+* Private Types Definitions
+ ************************************************************************************************************/
+
+typedef enum {
+	HISTORY_FIELD_P_MIN = 0,
+	HISTORY_FIELD_P_AVG,
+	HISTORY_FIELD_P_MAX,
+	HISTORY_FIELD_V_MIN,
+	HISTORY_FIELD_V_AVG,
+	HISTORY_FIELD_V_MAX
+} history_field_t;
+
+// Partial sums of the point being built, mergeable into a coarser tier.
+typedef struct {
+	uint32_t n;
+
+	float p_sum;
+	float p_min;
+	float p_max;
+
+	float v_sum;
+	float v_min;
+	float v_max;
+} history_acc_t;
+
+typedef struct {
+	uint32_t period_s;
+	uint32_t len;
+	uint32_t pushed;
+
+	// Time slot (uptime / `period_s`) of the point being built, -1 if none.
+	int64_t slot;
+	history_acc_t acc;
+
+	// `HISTORY_FIELDS` arrays of `len` elements.
+	int16_t *data;
+} history_tier_t;
+
+typedef struct {
+	float p_w;
+	float v_rms;
+	int64_t timestamp_us;
+} history_window_t;
+
+/************************************************************************************************************
+* Private Variables
+ ************************************************************************************************************/
+
+static const char *TAG = LOG_TAG;
+
+static TaskHandle_t __history_task_handle = NULL;
+static QueueHandle_t __history_queue;
+
+// Tiers, shared with `history_get_tier_info()` and `history_read()`.
+static history_tier_t __history_tiers[HISTORY_TIERS];
+static SemaphoreHandle_t __history_mutex;
+
+/************************************************************************************************************
+* Private Functions Prototypes
+ ************************************************************************************************************/
+
+static esp_err_t __history_tiers_setup();
+static esp_err_t __history_task_setup();
+
+static void __acc_reset(history_acc_t *acc);
+static void __acc_merge(history_acc_t *acc, history_acc_t *src);
+static int16_t __quantize(float x, float scale);
+
+/**
+ * @brief Store a point on the ring buffer of `tier` (`acc` is `NULL` for a point without data).
+ */
+static void __tier_push(history_tier_t *tier, history_acc_t *acc);
+
+/**
+ * @brief Merge `acc`, that ends at the uptime `t_s`, into the point being built on tier `k`.
+ * Closed points are pushed and cascaded to the next tier.
+ */
+static void __tier_add(uint8_t k, history_acc_t *acc, int64_t t_s);
+
+static void __history_task(void *parameters);
+
+/************************************************************************************************************
+* Private Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t __history_tiers_setup(){
+
+	uint32_t periods_s[] = HISTORY_TIER_PERIODS_S;
+	uint32_t lens[] = HISTORY_TIER_LENS;
+
+	for(uint8_t k=0; k<HISTORY_TIERS; k++){
+
+		// Every point must be made of whole points of the finer tier.
+		ESP_RETURN_ON_FALSE(
+			k == 0 || periods_s[k] % periods_s[k - 1] == 0,
+
+			ESP_ERR_INVALID_ARG,
+			TAG,
+			"Error: tier %u period is not a multiple of tier %u period",
+			k + 1, k
+		);
+
+		__history_tiers[k] = (history_tier_t){
+			.period_s = periods_s[k],
+			.len = lens[k],
+			.pushed = 0,
+			.slot = -1,
+			.data = malloc(HISTORY_FIELDS * lens[k] * sizeof(int16_t))
+		};
+
+		ESP_RETURN_ON_FALSE(
+			__history_tiers[k].data != NULL,
+
+			ESP_ERR_NO_MEM,
+			TAG,
+			"Error: unable to allocate tier %u (%u bytes)",
+			k + 1, HISTORY_FIELDS * lens[k] * sizeof(int16_t)
+		);
+
+		__acc_reset(&__history_tiers[k].acc);
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t __history_task_setup(){
+
+	__history_mutex = xSemaphoreCreateMutex();
+	ESP_RETURN_ON_FALSE(
+		__history_mutex != NULL,
+
+		ESP_ERR_NO_MEM,
+		TAG,
+		"Error: unable to allocate `__history_mutex`"
+	);
+
+	__history_queue = xQueueCreate(
+		HISTORY_QUEUE_BUFFER_LEN_ELEMENTS,
+		sizeof(history_window_t)
+	);
+
+	ESP_RETURN_ON_FALSE(
+		__history_queue != NULL,
+
+		ESP_ERR_NO_MEM,
+		TAG,
+		"Error: unable to allocate `__history_queue`"
+	);
+
+	BaseType_t ret_val = xTaskCreatePinnedToCore(
+		__history_task,
+		LOG_TAG "_task",
+		CONFIG_HISTORY_TASK_STACK_SIZE_BYTES,
+		NULL,
+		CONFIG_HISTORY_TASK_PRIORITY,
+		&__history_task_handle,
+		CONFIG_HISTORY_TASK_CORE_AFFINITY
+	);
+
+	ESP_RETURN_ON_FALSE(
+		ret_val == pdPASS,
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error %d: unable to spawn \"" LOG_TAG "_task\"",
+		ret_val
+	);
+
+	return ESP_OK;
+}
+
+void __acc_reset(history_acc_t *acc){
+	*acc = (history_acc_t){
+		.n = 0,
+
+		.p_sum = 0,
+		.p_min = INFINITY,
+		.p_max = -INFINITY,
+
+		.v_sum = 0,
+		.v_min = INFINITY,
+		.v_max = -INFINITY
+	};
+}
+
+void __acc_merge(history_acc_t *acc, history_acc_t *src){
+	acc->n += src->n;
+
+	acc->p_sum += src->p_sum;
+	acc->p_min = fminf(acc->p_min, src->p_min);
+	acc->p_max = fmaxf(acc->p_max, src->p_max);
+
+	acc->v_sum += src->v_sum;
+	acc->v_min = fminf(acc->v_min, src->v_min);
+	acc->v_max = fmaxf(acc->v_max, src->v_max);
+}
+
+int16_t __quantize(float x, float scale){
+	x = roundf(x * scale);
+
+	if(x > INT16_MAX)
+		return INT16_MAX;
+
+	// `INT16_MIN` is `HISTORY_NO_DATA`.
+	if(x <= INT16_MIN)
+		return INT16_MIN + 1;
+
+	return x;
+}
+
+void __tier_push(history_tier_t *tier, history_acc_t *acc){
+	uint32_t i = tier->pushed % tier->len;
+
+	if(acc == NULL || acc->n == 0)
+		for(uint8_t field=0; field<HISTORY_FIELDS; field++)
+			__tier_field(tier, field, i) = HISTORY_NO_DATA;
+
+	else {
+		__tier_field(tier, HISTORY_FIELD_P_MIN, i) = __quantize(acc->p_min, HISTORY_P_SCALE);
+		__tier_field(tier, HISTORY_FIELD_P_AVG, i) = __quantize(acc->p_sum / acc->n, HISTORY_P_SCALE);
+		__tier_field(tier, HISTORY_FIELD_P_MAX, i) = __quantize(acc->p_max, HISTORY_P_SCALE);
+
+		__tier_field(tier, HISTORY_FIELD_V_MIN, i) = __quantize(acc->v_min, HISTORY_V_SCALE);
+		__tier_field(tier, HISTORY_FIELD_V_AVG, i) = __quantize(acc->v_sum / acc->n, HISTORY_V_SCALE);
+		__tier_field(tier, HISTORY_FIELD_V_MAX, i) = __quantize(acc->v_max, HISTORY_V_SCALE);
+	}
+
+	tier->pushed++;
+}
+
+void __tier_add(uint8_t k, history_acc_t *acc, int64_t t_s){
+	history_tier_t *tier = &__history_tiers[k];
+	int64_t slot = t_s / tier->period_s;
+
+	if(slot != tier->slot){
+
+		// Close the current point and cascade it to the coarser tier.
+		if(tier->slot >= 0){
+			__tier_push(tier, &tier->acc);
+
+			if(k + 1 < HISTORY_TIERS)
+				__tier_add(k + 1, &tier->acc, tier->slot * tier->period_s);
+
+			// Keep the time axis regular across gaps (no windows, e.g. ADC errors).
+			int64_t gap = slot - tier->slot - 1;
+			if(gap > tier->len)
+				gap = tier->len;
+
+			while(gap-- > 0)
+				__tier_push(tier, NULL);
+		}
+
+		tier->slot = slot;
+		__acc_reset(&tier->acc);
+	}
+
+	__acc_merge(&tier->acc, acc);
+}
+
+void __history_task(void *parameters){
+
+	ESP_LOGI(TAG, "Started");
+
+	/* Variables */
+
+	// Incoming window.
+	history_window_t window;
+	history_acc_t acc;
+
+	/* Code */
+
+	/* Infinite loop */
+	for(;;){
+
+		// Waiting for `history_add_window()` requests.
+		if(xQueueReceive(__history_queue, &window, portMAX_DELAY) == pdFALSE)
+			continue;
+
+		acc = (history_acc_t){
+			.n = 1,
+
+			.p_sum = window.p_w,
+			.p_min = window.p_w,
+			.p_max = window.p_w,
+
+			.v_sum = window.v_rms,
+			.v_min = window.v_rms,
+			.v_max = window.v_rms
+		};
+
+		xSemaphoreTake(__history_mutex, portMAX_DELAY);
+		__tier_add(0, &acc, window.timestamp_us / 1000000);
+		xSemaphoreGive(__history_mutex);
+	}
+}
+
+/************************************************************************************************************
+* Public Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t history_setup(){
+
+	ESP_RETURN_ON_ERROR(
+		__history_tiers_setup(),
+
+		TAG,
+		"Error on `__history_tiers_setup()`"
+	);
+
+	ESP_RETURN_ON_ERROR(
+		__history_task_setup(),
+
+		TAG,
+		"Error on `__history_task_setup()`"
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t history_add_window(ul_pm_results_t *ul_pm_results){
+
+	// Called by `__pm_task` on every window: no logs here.
+	if(!__is_initialized() || ul_pm_results == NULL)
+		return ESP_ERR_INVALID_STATE;
+
+	history_window_t window = {
+		.p_w = ul_pm_results->p_w,
+		.v_rms = ul_pm_results->v_rms,
+		.timestamp_us = micros()
+	};
+
+	if(xQueueSend(__history_queue, &window, 0) != pdTRUE)
+		return ESP_ERR_NO_MEM;
+
+	return ESP_OK;
+}
+
+esp_err_t history_get_tier_info(uint8_t tier, history_tier_info_t *history_tier_info){
+	assert_param_notnull(history_tier_info);
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	ESP_RETURN_ON_FALSE(
+		tier < HISTORY_TIERS,
+
+		ESP_ERR_INVALID_ARG,
+		TAG,
+		"Error: tier %u does not exist",
+		tier
+	);
+
+	history_tier_t *t = &__history_tiers[tier];
+
+	xSemaphoreTake(__history_mutex, portMAX_DELAY);
+
+	*history_tier_info = (history_tier_info_t){
+		.period_s = t->period_s,
+		.len = t->len,
+		.count = (t->pushed < t->len ? t->pushed : t->len),
+		.pushed = t->pushed,
+		.end_s = (t->slot < 0 ? 0 : t->slot * t->period_s)
+	};
+
+	xSemaphoreGive(__history_mutex);
+	return ESP_OK;
+}
+
+esp_err_t history_read(uint8_t tier, uint32_t first, history_point_t *points, uint32_t *points_len){
+	assert_param_notnull(points);
+	assert_param_notnull(points_len);
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	ESP_RETURN_ON_FALSE(
+		tier < HISTORY_TIERS,
+
+		ESP_ERR_INVALID_ARG,
+		TAG,
+		"Error: tier %u does not exist",
+		tier
+	);
+
+	history_tier_t *t = &__history_tiers[tier];
+	uint32_t n = 0, abs_i, i;
+
+	xSemaphoreTake(__history_mutex, portMAX_DELAY);
+
+	for(; n<*points_len; n++){
+		abs_i = first + n;
+
+		// Not stored yet.
+		if(abs_i >= t->pushed)
+			break;
+
+		// Already overwritten.
+		if(t->pushed - abs_i > t->len){
+			points[n] = (history_point_t){
+				HISTORY_NO_DATA, HISTORY_NO_DATA, HISTORY_NO_DATA,
+				HISTORY_NO_DATA, HISTORY_NO_DATA, HISTORY_NO_DATA
+			};
+
+			continue;
+		}
+
+		i = abs_i % t->len;
+		points[n] = (history_point_t){
+			.p_min = __tier_field(t, HISTORY_FIELD_P_MIN, i),
+			.p_avg = __tier_field(t, HISTORY_FIELD_P_AVG, i),
+			.p_max = __tier_field(t, HISTORY_FIELD_P_MAX, i),
+
+			.v_min = __tier_field(t, HISTORY_FIELD_V_MIN, i),
+			.v_avg = __tier_field(t, HISTORY_FIELD_V_AVG, i),
+			.v_max = __tier_field(t, HISTORY_FIELD_V_MAX, i)
+		};
+	}
+
+	xSemaphoreGive(__history_mutex);
+
+	*points_len = n;
+	return ESP_OK;
+}
@@ -41,6 +41,11 @@
 #include <wifi.h>
 #include <fs.h>
 #include <webserver.h>
+#include <energy.h>
+#include <demand.h>
+#include <history.h>
+#include <shedding.h>
+#include <pq.h>
 #include <pm.h>
 
 // !!! OTTIMIZZARE CODICE ZONE.H
@@ -119,6 +124,21 @@ void app_main(){
 	ESP_LOGI(TAG, "webserver_setup()");
 	ESP_ERROR_CHECK(webserver_setup());
 
+	ESP_LOGI(TAG, "energy_setup()");
+	ESP_ERROR_CHECK(energy_setup());
+
+	ESP_LOGI(TAG, "demand_setup()");
+	ESP_ERROR_CHECK(demand_setup());
+
+	ESP_LOGI(TAG, "history_setup()");
+	ESP_ERROR_CHECK(history_setup());
+
+	ESP_LOGI(TAG, "shedding_setup()");
+	ESP_ERROR_CHECK(shedding_setup());
+
+	ESP_LOGI(TAG, "pq_setup()");
+	ESP_ERROR_CHECK(pq_setup());
+
 	ESP_LOGI(TAG, "pm_setup()");
 	ESP_ERROR_CHECK(pm_setup());
 
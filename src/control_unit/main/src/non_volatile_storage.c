@@ -105,3 +105,95 @@ esp_err_t nvs_new_handle(nvs_handle_t *nvs_handle, const char *nvs_namespace){
 
 	return ESP_OK;
 }
+
+esp_err_t nvs_load_blob(const char *nvs_namespace, const char *key, void *blob, size_t len){
+	assert_param_notnull(key);
+	assert_param_notnull(blob);
+	assert_param_size_ok(len);
+
+	esp_err_t ret = ESP_OK;
+
+	nvs_handle_t nvs_handle;
+	size_t stored_len = len;
+
+	memset(blob, 0, len);
+
+	ESP_RETURN_ON_ERROR(
+		nvs_new_handle(
+			&nvs_handle,
+			nvs_namespace
+		),
+
+		TAG,
+		"Error on `nvs_new_handle()`"
+	);
+
+	ret = nvs_get_blob(nvs_handle, key, blob, &stored_len);
+
+	// First boot.
+	if(ret == ESP_ERR_NVS_NOT_FOUND)
+		ret = ESP_OK;
+
+	else if(ret == ESP_OK && stored_len != len)
+		ret = ESP_ERR_INVALID_SIZE;
+
+	ESP_GOTO_ON_ERROR(
+		ret,
+
+		label_error,
+		TAG,
+		"Error on `nvs_get_blob(key=\"%s\")`", key
+	);
+
+	label_cleanup:
+	nvs_close(nvs_handle);
+	return ret;
+
+	label_error:
+	memset(blob, 0, len);
+	goto label_cleanup;
+}
+
+esp_err_t nvs_save_blob(const char *nvs_namespace, const char *key, const void *blob, size_t len){
+	assert_param_notnull(key);
+	assert_param_notnull(blob);
+	assert_param_size_ok(len);
+
+	esp_err_t ret = ESP_OK;
+	nvs_handle_t nvs_handle;
+
+	ESP_RETURN_ON_ERROR(
+		nvs_new_handle(
+			&nvs_handle,
+			nvs_namespace
+		),
+
+		TAG,
+		"Error on `nvs_new_handle()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		nvs_set_blob(
+			nvs_handle,
+			key,
+			blob,
+			len
+		),
+
+		label_cleanup,
+		TAG,
+		"Error on `nvs_set_blob(key=\"%s\")`", key
+	);
+
+	ESP_GOTO_ON_ERROR(
+		nvs_commit(nvs_handle),
+
+		label_cleanup,
+		TAG,
+		"Error on `nvs_commit()`"
+	);
+
+	label_cleanup:
+	nvs_close(nvs_handle);
+	return ret;
+}
@@ -13,6 +13,7 @@
 
 #include <pm.h>
 #include <private.h>
+#include <seqlock.h>
 
 /************************************************************************************************************
 * Private Defines
@@ -21,25 +22,135 @@
 #define LOG_TAG	"pm"
 // #define LOG_RESULTS
 
-// Voltage and current channels.
-#define ADC_CHANNELS	2
+// Voltage, main current and sub-metered circuits currents.
+#define ADC_CHANNELS	(2 + CONFIG_PM_CIRCUITS)
 #define ADC_BYTES_PER_SAMPLE	sizeof(adc_digi_output_data_t)
 
+// Size of a set of samples, one for every channel.
+#define ADC_SET_SIZE_BYTES	( \
+	ADC_CHANNELS * ADC_BYTES_PER_SAMPLE \
+)
+
+// Size of a pair of voltage and current samples.
+#define ADC_PAIR_SIZE_BYTES	( \
+	2 * ADC_BYTES_PER_SAMPLE \
+)
+
 // This number must be a multiple of `SOC_ADC_DIGI_DATA_BYTES_PER_CONV` on `soc/soc_caps.h`.
-#define ADC_BUF_SIZE_BYTES	( \
-	ADC_CHANNELS * ADC_BYTES_PER_SAMPLE * CONFIG_PM_ADC_SAMPLES \
+#define ADC_FRAME_SIZE_BYTES	( \
+	ADC_SET_SIZE_BYTES * CONFIG_PM_ADC_FRAME_SAMPLES \
 )
 
+// `__samples` rows.
+#define ADC_ROW_V					0
+#define ADC_ROW_I					1
+#define ADC_ROW_CIRCUITS	2
+
+// `__adc_channel_rows` value of the ADC channels not sampled.
+#define ADC_ROW_NONE	0xFF
+
+// Circuits current clamps GPIO pads.
+#ifdef CONFIG_GPIO_AC_I_CIRCUIT_1
+#define __circuit_gpio_1	CONFIG_GPIO_AC_I_CIRCUIT_1,
+#else
+#define __circuit_gpio_1
+#endif
+
+#ifdef CONFIG_GPIO_AC_I_CIRCUIT_2
+#define __circuit_gpio_2	CONFIG_GPIO_AC_I_CIRCUIT_2,
+#else
+#define __circuit_gpio_2
+#endif
+
+#ifdef CONFIG_GPIO_AC_I_CIRCUIT_3
+#define __circuit_gpio_3	CONFIG_GPIO_AC_I_CIRCUIT_3,
+#else
+#define __circuit_gpio_3
+#endif
+
+#ifdef CONFIG_GPIO_AC_I_CIRCUIT_4
+#define __circuit_gpio_4	CONFIG_GPIO_AC_I_CIRCUIT_4,
+#else
+#define __circuit_gpio_4
+#endif
+
+#ifdef CONFIG_GPIO_AC_I_CIRCUIT_5
+#define __circuit_gpio_5	CONFIG_GPIO_AC_I_CIRCUIT_5,
+#else
+#define __circuit_gpio_5
+#endif
+
 /**
- * `adc_continuous_read()` timeout value (e.g. 200ms = ten 50Hz cycles).
+ * Number of DMA frames the driver can store while `__pm_task` is busy evaluating a window.
+ * If the pool fills up, the newest frames are dropped and counted in `__adc_lost_frames`.
+ */
+#define ADC_POOL_FRAMES	8
+
+/**
+ * Measurement window length (e.g. 200ms = ten 50Hz cycles).
  * Period of time in which the read data becomes obsolete.
  */
 #define ADC_CONTINUOUS_READ_TIMEOUT_MS	( \
 	(CONFIG_PM_ADC_SAMPLES * 1000) / CONFIG_PM_ADC_SAMPLE_RATE \
 )
 
+/**
+ * Sample rate of each channel, as assumed by `ADC_CONTINUOUS_READ_TIMEOUT_MS`.
+ * Used by `ul_pm` to measure the mains frequency.
+ */
+#define ADC_CHANNEL_SAMPLE_RATE	CONFIG_PM_ADC_SAMPLE_RATE
+
+// The continuous mode conversion rate is shared by every channel of the pattern.
+#define ADC_CONVERSION_RATE	(ADC_CHANNEL_SAMPLE_RATE * ADC_CHANNELS)
+
+#if ADC_CONVERSION_RATE > SOC_ADC_SAMPLE_FREQ_THRES_HIGH
+	#error CONFIG_PM_ADC_SAMPLE_RATE is too high for (2 + CONFIG_PM_CIRCUITS) channels.
+#endif
+
 #define ALARM_TOGGLE_PERIOD_MS	100
 
+// Samples per channel of a medium and of a slow rate period: periods end with the first window past them.
+#define PM_RATE_MEDIUM_SAMPLES	((uint64_t) ADC_CHANNEL_SAMPLE_RATE * CONFIG_PM_RATE_MEDIUM_PERIOD_MS / 1000)
+#define PM_RATE_SLOW_SAMPLES		((uint64_t) ADC_CHANNEL_SAMPLE_RATE * CONFIG_PM_RATE_SLOW_PERIOD_S)
+
+// Relay zones opened by the fast overcurrent trip, terminated by `ZONE_UNMAPPED`.
+#define PM_FAST_TRIP_ZONES	{ \
+	__fast_trip_relay_1 \
+	__fast_trip_relay_2 \
+	__fast_trip_relay_3 \
+	__fast_trip_relay_4 \
+	ZONE_UNMAPPED \
+}
+
+#ifdef CONFIG_PM_FAST_TRIP_OPEN_RELAY_1
+#define __fast_trip_relay_1	ZONE_RELAY_1,
+#else
+#define __fast_trip_relay_1
+#endif
+
+#ifdef CONFIG_PM_FAST_TRIP_OPEN_RELAY_2
+#define __fast_trip_relay_2	ZONE_RELAY_2,
+#else
+#define __fast_trip_relay_2
+#endif
+
+#ifdef CONFIG_PM_FAST_TRIP_OPEN_RELAY_3
+#define __fast_trip_relay_3	ZONE_RELAY_3,
+#else
+#define __fast_trip_relay_3
+#endif
+
+#ifdef CONFIG_PM_FAST_TRIP_OPEN_RELAY_4
+#define __fast_trip_relay_4	ZONE_RELAY_4,
+#else
+#define __fast_trip_relay_4
+#endif
+
+// Raw waveform capture buffer length.
+#define PM_CAPTURE_BUFFER_LEN_BYTES	( \
+	CONFIG_PM_CAPTURE_MAX_PAIRS * ADC_PAIR_SIZE_BYTES \
+)
+
 /**
  * @brief Statement to check if the library was initialized.
  */
@@ -51,6 +162,17 @@
 * Private Types Definitions
  ************************************************************************************************************/
 
+typedef enum {
+	PM_CAPTURE_STATE_IDLE = 0,
+
+	// Set by `pm_capture()`: `__pm_task` starts on the next window.
+	PM_CAPTURE_STATE_REQUESTED,
+	PM_CAPTURE_STATE_RUNNING,
+
+	// Buffer owned by `pm_capture()` until `pm_capture_release()`.
+	PM_CAPTURE_STATE_DONE
+} pm_capture_state_t;
+
 /************************************************************************************************************
 * Private Variables
  ************************************************************************************************************/
@@ -61,23 +183,103 @@ static TaskHandle_t __pm_task_handle = NULL;
 static adc_continuous_handle_t __adc_handle;
 static ul_pm_handle_t *__pm_handle;
 
-// Voltage and current channels.
-static struct __attribute__((__packed__)) {
-
-	adc_channel_t v_channel: 4;
-	adc_channel_t i_channel: 4;
+// `__samples` row of every ADC channel (`channel:4`), or `ADC_ROW_NONE`.
+static uint8_t __adc_channel_rows[16];
 
-} adc_channels;
+#if CONFIG_PM_CIRCUITS > 0
+static ul_pm_circuits_t *__pm_circuits;
+#endif
 
-// `ul_pm_evaluate()` results.
+// `ul_pm_stream_finalize()` results, private to `__pm_task`.
 static ul_pm_results_t __pm_res;
-static SemaphoreHandle_t __pm_res_mutex;
+
+/**
+ * Results published by `__pm_task` with a sequence lock: the sequence number is odd while
+ * a copy is being written. Readers never block `__pm_task`, and `__pm_task` never waits for them.
+ */
+static struct {
+	volatile uint32_t seq;
+	ul_pm_results_t res;
+} __pm_res_shared;
+
+static struct {
+	volatile uint32_t seq;
+	ul_pm_cycle_results_t res;
+} __pm_cycle_res_shared;
+
+#if CONFIG_PM_CIRCUITS > 0
+static ul_pm_circuit_results_t __pm_circuits_res[CONFIG_PM_CIRCUITS];
+
+static struct {
+	volatile uint32_t seq;
+	ul_pm_circuit_results_t res[CONFIG_PM_CIRCUITS];
+} __pm_circuits_res_shared;
+#endif
+
+// Partial sums of the running period of each rate, private to `__pm_task`.
+static ul_pm_aggregate_t __pm_aggregates[PM_RATES];
+
+static struct {
+	volatile uint32_t seq;
+	ul_pm_aggregate_results_t res;
+} __pm_aggregates_res_shared[PM_RATES];
 
 static TimerHandle_t __alarm_timer_handle;
 
-// Sample buffer.
-static uint8_t __buffer[ADC_BUF_SIZE_BYTES];
-static uint8_t __v_sample_offset, __i_sample_offset;
+/**
+ * Sample buffer: a single DMA frame, deinterleaved as soon as it is read into `__samples`,
+ * one contiguous row per channel (voltage, main current, then the circuits currents).
+ * The `ul_pm_span_t` layouts describe the voltage and main current rows for `ul_pm_stream_feed_span()`.
+ */
+static uint8_t __buffer[ADC_FRAME_SIZE_BYTES];
+static uint16_t __samples[ADC_CHANNELS][CONFIG_PM_ADC_FRAME_SAMPLES];
+static ul_pm_span_t __v_span, __i_span;
+
+// DMA frames dropped by the driver because `__pm_task` did not keep up.
+static volatile uint32_t __adc_lost_frames = 0;
+
+/**
+ * Fast overcurrent trip: `CONFIG_PM_FAST_TRIP_CURRENT_A` in raw ADC units (0 if disabled),
+ * and consecutive samples above it so far (they can span two DMA frames).
+ */
+static int32_t __fast_trip_threshold = 0;
+static uint8_t __fast_trip_samples = 0;
+
+/**
+ * Raw waveform capture: `__capture_append()` interleaves again the voltage and main current rows of `__samples`
+ * fed to `ul_pm` into 12-bit pairs, so that `pm_capture()` hands the buffer out as it is.
+ */
+static struct {
+	volatile pm_capture_state_t state;
+
+	// Allocated on the first capture.
+	uint8_t *buffer;
+	uint32_t len;
+
+	uint8_t windows;
+	uint8_t windows_len;
+	bool truncated;
+} __capture = {
+	.state = PM_CAPTURE_STATE_IDLE,
+	.buffer = NULL
+};
+
+static SemaphoreHandle_t __capture_mutex;
+static SemaphoreHandle_t __capture_done;
+
+/**
+ * Power-quality snapshot: ring of the latest DMA frames, always running until an event starts;
+ * it is then frozen after `CONFIG_PQ_POST_TRIGGER_FRAMES` more frames, until `__pq_task` has saved it.
+ */
+static uint8_t __pq_frames[PQ_SNAPSHOT_FRAMES * ADC_FRAME_SIZE_BYTES];
+static pq_snapshot_t __pq_snapshot;
+
+// Frames to be stored after the trigger: -1 while running, 0 once frozen.
+static int8_t __pq_post_frames = -1;
+
+// The event in progress owns the snapshot, and it ended.
+static bool __pq_event_snapshot = false;
+static bool __pq_event_ended = false;
 
 /************************************************************************************************************
 * Private Functions Prototypes
@@ -90,8 +292,56 @@ static esp_err_t __pm_task_setup();
 static esp_err_t __set_alarm(bool state);
 static void __alarm_timer(TimerHandle_t timer);
 
-static uint16_t __pm_get_sample(void *user_context, ul_pm_sample_type_t sample_type, uint32_t index);
-static bool __adc_conversion_done(adc_continuous_handle_t adc_handle, const adc_continuous_evt_data_t *edata, void *user_data);
+static bool __adc_pool_overflow(adc_continuous_handle_t adc_handle, const adc_continuous_evt_data_t *edata, void *user_data);
+static void __pm_cycle_done(void *user_context, ul_pm_cycle_results_t *res);
+
+/**
+ * @brief Split the `read_len` bytes of `__buffer` into the `__samples` rows.
+ * @return The number of samples of every channel.
+ */
+static uint32_t __deinterleave(uint32_t read_len);
+
+/**
+ * @brief Check the first `samples_len` main current samples against the fast trip threshold.
+ * @return `true` once `CONFIG_PM_FAST_TRIP_SAMPLES` consecutive samples exceed it.
+ */
+static bool __fast_trip_check(uint32_t samples_len);
+
+/**
+ * @brief Open the `PM_FAST_TRIP_ZONES` relays and turn on the alarm.
+ */
+static esp_err_t __fast_trip();
+
+/**
+ * @brief Called by `__pm_task` for every chunk fed to `ul_pm` (`pairs_len` samples of `__samples` from `offset`)
+ * and on every window boundary.
+ */
+static void __capture_append(uint32_t offset, uint32_t pairs_len);
+static void __capture_window_done();
+
+/**
+ * @brief Close the periods of the rates that are complete: the medium period is published and merged
+ * into the slow one, which is published in turn when complete.
+ * @note The window partial sums must be already merged into `__pm_aggregates[PM_RATE_MEDIUM]`.
+ */
+static void __rates_window_done();
+
+/**
+ * @brief Evaluate and publish the period of `rate` to `res`, then start a new one.
+ */
+static esp_err_t __rate_publish(pm_rate_t rate, ul_pm_aggregate_results_t *res);
+
+/**
+ * @brief Called by `__pm_task` on every DMA frame read on `__buffer`, and on every mains
+ * cycle (or window without cycles) to run the power-quality detector.
+ */
+static void __pq_frame(uint32_t read_len);
+static void __pq_cycle(float v_rms, float i_rms);
+
+/**
+ * @brief Submit the ended event, once its post-trigger frames are stored.
+ */
+static void __pq_submit();
 
 static void __pm_task(void *parameters);
 
@@ -106,8 +356,8 @@ esp_err_t __adc_driver_setup(){
 	 * Please read the descriprion of `esp_adc/adc_continuous.h`.
 	 */
 	adc_continuous_handle_cfg_t adc_memory_config = {
-		.max_store_buf_size = ADC_BUF_SIZE_BYTES,
-		.conv_frame_size = ADC_BUF_SIZE_BYTES,
+		.max_store_buf_size = ADC_FRAME_SIZE_BYTES * ADC_POOL_FRAMES,
+		.conv_frame_size = ADC_FRAME_SIZE_BYTES,
 		.flags.flush_pool = false
 	};
 
@@ -117,10 +367,15 @@ esp_err_t __adc_driver_setup(){
 		"Error on `adc_continuous_new_handle()`"
 	);
 
-	// ADC GPIO pads.
+	// ADC GPIO pads, in `__samples` rows order.
 	uint8_t adc_gpio[] = {
 		CONFIG_GPIO_AC_V,
-		CONFIG_GPIO_AC_I
+		CONFIG_GPIO_AC_I,
+		__circuit_gpio_1
+		__circuit_gpio_2
+		__circuit_gpio_3
+		__circuit_gpio_4
+		__circuit_gpio_5
 	};
 
 	// Corresponding ADC unit to `adc_gpio[i]` (must always be `ADC_UNIT_1`).
@@ -132,6 +387,8 @@ esp_err_t __adc_driver_setup(){
 	// Configurations for every specified ADC channel.
 	adc_digi_pattern_config_t adc_channel_config[sizeof(adc_gpio)];
 
+	memset(__adc_channel_rows, ADC_ROW_NONE, sizeof(__adc_channel_rows));
+
 	for(uint8_t i=0; i<sizeof(adc_gpio); i++){
 
 		ESP_RETURN_ON_ERROR(
@@ -155,22 +412,17 @@ esp_err_t __adc_driver_setup(){
 			i
 		);
 
-		// Save channel number.
-		switch(i){
-
-			// Voltage channel.
-			case 0:
-				adc_channels.v_channel = adc_channel;
-				break;
+		ESP_RETURN_ON_FALSE(
+			__adc_channel_rows[adc_channel] == ADC_ROW_NONE,
 
-			// Current channel.
-			case 1:
-				adc_channels.i_channel = adc_channel;
-				break;
+			ESP_ERR_INVALID_ARG,
+			TAG,
+			"Error: GPIO %u is used twice",
+			adc_gpio[i]
+		);
 
-			default:
-				break;
-		}
+		// Save channel row.
+		__adc_channel_rows[adc_channel] = i;
 
 		// Channel configurations.
 		adc_channel_config[i].channel = adc_channel;
@@ -181,7 +433,7 @@ esp_err_t __adc_driver_setup(){
 
 	// Driver global configurations.
 	adc_continuous_config_t adc_digital_config = {
-		.sample_freq_hz = CONFIG_PM_ADC_SAMPLE_RATE,
+		.sample_freq_hz = ADC_CONVERSION_RATE,
 		.conv_mode = ADC_CONV_SINGLE_UNIT_1,
 		.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
 		.pattern_num = sizeof(adc_gpio),
@@ -199,7 +451,7 @@ esp_err_t __adc_driver_setup(){
 	);
 
 	adc_continuous_evt_cbs_t adc_callbacks = {
-		.on_conv_done = __adc_conversion_done
+		.on_pool_ovf = __adc_pool_overflow
 	};
 
 	ESP_RETURN_ON_ERROR(
@@ -233,9 +485,35 @@ esp_err_t __pm_code_setup(){
 		.v_correction_factor = 0.98,
 		.i_correction_factor = 1.08,
 
-		.sample_callback = __pm_get_sample
+		/**
+		 * Windows of `CONFIG_PM_CYCLES_PER_WINDOW` whole mains cycles;
+		 * `CONFIG_PM_ADC_SAMPLES` is the window length if there is no mains (or if cycle alignment is disabled).
+		 */
+		.sample_rate_hz = ADC_CHANNEL_SAMPLE_RATE,
+		.cycles_per_window = CONFIG_PM_CYCLES_PER_WINDOW,
+		.window_samples = CONFIG_PM_ADC_SAMPLES,
+
+		.cycle_callback = __pm_cycle_done,
+		.cycle_callback_context = NULL,
+
+		#ifdef UL_CONFIG_PM_HARMONICS
+		.nominal_frequency_hz = CONFIG_PM_NOMINAL_FREQUENCY,
+		#endif
+
+		// Samples are read in place from `__samples` through `ul_pm_stream_feed_span()`.
+		.sample_callback = NULL
+	};
+
+	// Contiguous rows of 12-bit samples.
+	__v_span = __i_span = (ul_pm_span_t){
+		.offset_bytes = ADC_ROW_V * sizeof(__samples[0]),
+		.stride_bytes = sizeof(uint16_t),
+		.shift = 0,
+		.mask = 0x0FFF
 	};
 
+	__i_span.offset_bytes = ADC_ROW_I * sizeof(__samples[0]);
+
 	ESP_RETURN_ON_ERROR(
 		ul_errors_to_esp_err(
 			ul_pm_begin(
@@ -248,18 +526,56 @@ esp_err_t __pm_code_setup(){
 		"Error on `ul_pm_begin()`"
 	);
 
+	#if CONFIG_PM_CIRCUITS > 0
+	ESP_RETURN_ON_ERROR(
+		ul_errors_to_esp_err(
+			ul_pm_circuits_begin(
+				__pm_handle,
+				CONFIG_PM_CIRCUITS,
+				&__pm_circuits
+			)
+		),
+
+		TAG,
+		"Error on `ul_pm_circuits_begin()`"
+	);
+	#endif
+
+	// Peak current, relative to the DC offset.
+	if(CONFIG_PM_FAST_TRIP_CURRENT_A > 0)
+		__fast_trip_threshold = lroundf(CONFIG_PM_FAST_TRIP_CURRENT_A / __pm_handle->k_i);
+
+	__pq_snapshot = (pq_snapshot_t){
+		.frames = __pq_frames,
+		.frame_size_bytes = ADC_FRAME_SIZE_BYTES,
+		.head = 0,
+		.sample_rate_hz = ADC_CHANNEL_SAMPLE_RATE,
+		.v_scale = __pm_handle->k_v,
+		.i_scale = __pm_handle->k_i,
+		.busy = false
+	};
+
 	return ESP_OK;
 }
 
 esp_err_t __pm_task_setup(){
 
-	__pm_res_mutex = xSemaphoreCreateMutex();
+	__capture_mutex = xSemaphoreCreateMutex();
+	ESP_RETURN_ON_FALSE(
+		__capture_mutex != NULL,
+
+		ESP_ERR_NO_MEM,
+		TAG,
+		"Error: unable to allocate `__capture_mutex`"
+	);
+
+	__capture_done = xSemaphoreCreateBinary();
 	ESP_RETURN_ON_FALSE(
-		__pm_res_mutex != NULL,
+		__capture_done != NULL,
 
 		ESP_ERR_NO_MEM,
 		TAG,
-		"Error: unable to allocate `__pm_res_mutex`"
+		"Error: unable to allocate `__capture_done`"
 	);
 
 	__alarm_timer_handle = xTimerCreate(
@@ -344,23 +660,223 @@ void __alarm_timer(TimerHandle_t timer){
 	state = !state;
 }
 
-uint16_t __pm_get_sample(void *user_context, ul_pm_sample_type_t sample_type, uint32_t index){
+bool __adc_pool_overflow(adc_continuous_handle_t adc_handle, const adc_continuous_evt_data_t *edata, void *user_data){
+	__adc_lost_frames++;
+	return false;
+}
+
+void __pm_cycle_done(void *user_context, ul_pm_cycle_results_t *res){
+
+	// Called by `__pm_task` every mains cycle.
+	__seqlock_write(
+		&__pm_cycle_res_shared.seq,
+		&__pm_cycle_res_shared.res,
+		res,
+		sizeof(ul_pm_cycle_results_t)
+	);
+
+	__pq_cycle(res->v_rms, res->i_rms);
+}
+
+uint32_t __deinterleave(uint32_t read_len){
+
+	adc_digi_output_data_t *raw = (adc_digi_output_data_t*) __buffer;
+	uint32_t rows_len[ADC_CHANNELS] = { 0 };
+	uint32_t samples_len;
+	uint8_t row;
+
+	// Every sample goes to the row of its channel, whatever the order of the frame.
+	for(uint32_t j=0; j<read_len / ADC_BYTES_PER_SAMPLE; j++){
+		row = __adc_channel_rows[raw[j].type1.channel];
+
+		if(row == ADC_ROW_NONE || rows_len[row] == CONFIG_PM_ADC_FRAME_SAMPLES)
+			continue;
+
+		__samples[row][rows_len[row]++] = raw[j].type1.data;
+	}
+
+	// Only complete sets.
+	samples_len = rows_len[0];
+
+	for(row=1; row<ADC_CHANNELS; row++)
+		if(rows_len[row] < samples_len)
+			samples_len = rows_len[row];
+
+	return samples_len;
+}
+
+bool __fast_trip_check(uint32_t samples_len){
+
+	uint16_t *i_samples = __samples[ADC_ROW_I];
+	int32_t i_offset = __pm_handle->stream.i_offset;
+	int32_t i_val;
+
+	for(uint32_t j=0; j<samples_len; j++){
+		i_val = (int32_t) i_samples[j] - i_offset;
+
+		if(i_val < __fast_trip_threshold && i_val > -__fast_trip_threshold){
+			__fast_trip_samples = 0;
+			continue;
+		}
+
+		if(++__fast_trip_samples >= CONFIG_PM_FAST_TRIP_SAMPLES){
+			__fast_trip_samples = 0;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+esp_err_t __fast_trip(){
+	esp_err_t ret = ESP_OK;
+	zone_t zones[] = PM_FAST_TRIP_ZONES;
+
+	// Relays first, then the alarm: every output is written even if another one fails.
+	for(uint8_t i=0; zones[i]!=ZONE_UNMAPPED; i++)
+		if(gpio_write_zone(zones[i], 0) != ESP_OK)
+			ret = ESP_FAIL;
+
+	if(gpio_set_alarm(1) != ESP_OK)
+		ret = ESP_FAIL;
+
+	return ret;
+}
+
+void __capture_append(uint32_t offset, uint32_t pairs_len){
+	uint16_t *pairs = (uint16_t*) &__capture.buffer[__capture.len];
+
+	if(__capture.len + pairs_len * ADC_PAIR_SIZE_BYTES > PM_CAPTURE_BUFFER_LEN_BYTES){
+		pairs_len = (PM_CAPTURE_BUFFER_LEN_BYTES - __capture.len) / ADC_PAIR_SIZE_BYTES;
+		__capture.truncated = true;
+	}
+
+	// Interleaved again, without the circuits.
+	for(uint32_t j=0; j<pairs_len; j++){
+		pairs[2 * j] = __samples[ADC_ROW_V][offset + j];
+		pairs[2 * j + 1] = __samples[ADC_ROW_I][offset + j];
+	}
+
+	__capture.len += pairs_len * ADC_PAIR_SIZE_BYTES;
+
+	if(__capture.truncated){
+		__capture.state = PM_CAPTURE_STATE_DONE;
+		xSemaphoreGive(__capture_done);
+	}
+}
+
+void __capture_window_done(){
+	switch(__capture.state){
 
-	index = (index * 2) + (
-		sample_type == UL_PM_SAMPLE_TYPE_VOLTAGE ?
-		__v_sample_offset :
-		__i_sample_offset
+		// Captures always start on a window boundary.
+		case PM_CAPTURE_STATE_REQUESTED:
+			__capture.len = 0;
+			__capture.windows_len = 0;
+			__capture.truncated = false;
+			__capture.state = PM_CAPTURE_STATE_RUNNING;
+			break;
+
+		case PM_CAPTURE_STATE_RUNNING:
+			if(++__capture.windows_len < __capture.windows)
+				break;
+
+			__capture.state = PM_CAPTURE_STATE_DONE;
+			xSemaphoreGive(__capture_done);
+			break;
+
+		default:
+			break;
+	}
+}
+
+void __rates_window_done(){
+
+	ul_pm_aggregate_results_t res;
+	uint32_t duration_ms;
+
+	if(__pm_aggregates[PM_RATE_MEDIUM].samples_len < PM_RATE_MEDIUM_SAMPLES)
+		return;
+
+	ul_pm_aggregate_merge(&__pm_aggregates[PM_RATE_SLOW], &__pm_aggregates[PM_RATE_MEDIUM]);
+	duration_ms = __pm_aggregates[PM_RATE_MEDIUM].samples_len * 1000 / ADC_CHANNEL_SAMPLE_RATE;
+
+	// Consumed by `__demand_task`: never blocks.
+	if(__rate_publish(PM_RATE_MEDIUM, &res) == ESP_OK)
+		demand_add_period(res.p_w, duration_ms);
+
+	if(__pm_aggregates[PM_RATE_SLOW].samples_len < PM_RATE_SLOW_SAMPLES)
+		return;
+
+	__rate_publish(PM_RATE_SLOW, &res);
+}
+
+esp_err_t __rate_publish(pm_rate_t rate, ul_pm_aggregate_results_t *res){
+	esp_err_t ret = ul_errors_to_esp_err(
+		ul_pm_aggregate_evaluate(__pm_handle, &__pm_aggregates[rate], res)
 	);
 
-	return ((adc_digi_output_data_t*) __buffer)[index].type1.data;
+	if(ret == ESP_OK)
+		__seqlock_write(
+			&__pm_aggregates_res_shared[rate].seq,
+			&__pm_aggregates_res_shared[rate].res,
+			res,
+			sizeof(ul_pm_aggregate_results_t)
+		);
+
+	__pm_aggregates[rate] = (ul_pm_aggregate_t){ 0 };
+	return ret;
+}
+
+void __pq_frame(uint32_t read_len){
+
+	// Saved by `__pq_task`: running again.
+	if(__pq_post_frames == 0 && !__pq_event_snapshot && !__pq_snapshot.busy)
+		__pq_post_frames = -1;
+
+	if(__pq_post_frames != 0){
+		memcpy(&__pq_frames[__pq_snapshot.head * ADC_FRAME_SIZE_BYTES], __buffer, read_len);
+		__pq_snapshot.frames_len[__pq_snapshot.head] = read_len;
+		__pq_snapshot.head = (__pq_snapshot.head + 1) % PQ_SNAPSHOT_FRAMES;
+
+		if(__pq_post_frames > 0)
+			__pq_post_frames--;
+	}
+
+	__pq_submit();
 }
 
-bool __adc_conversion_done(adc_continuous_handle_t adc_handle, const adc_continuous_evt_data_t *edata, void *user_data){
+void __pq_cycle(float v_rms, float i_rms){
+
+	switch(pq_detect(v_rms, i_rms)){
+		case PQ_DETECT_START:
+
+			// The trigger is in the newest frame; without a free ring the event is saved without samples.
+			__pq_event_snapshot = (__pq_post_frames < 0);
+			if(__pq_event_snapshot)
+				__pq_post_frames = CONFIG_PQ_POST_TRIGGER_FRAMES;
 
-	BaseType_t must_yield = pdFALSE;
-	vTaskNotifyGiveFromISR(__pm_task_handle, &must_yield);
+			break;
 
-	return (must_yield == pdTRUE);
+		case PQ_DETECT_END:
+			__pq_event_ended = true;
+			__pq_submit();
+			break;
+
+		default:
+			break;
+	}
+}
+
+void __pq_submit(){
+
+	if(!__pq_event_ended || (__pq_event_snapshot && __pq_post_frames > 0))
+		return;
+
+	// If the queue is full the event is lost, and the ring runs again.
+	pq_submit(__pq_event_snapshot ? &__pq_snapshot : NULL);
+
+	__pq_event_ended = false;
+	__pq_event_snapshot = false;
 }
 
 void __pm_task(void *parameters){
@@ -375,123 +891,216 @@ void __pm_task(void *parameters){
 	// Sample buffer read length.
 	uint32_t read_len;
 
-	// Alarm management.
+	// Sets of samples of `__samples` not yet fed to the current window.
+	uint32_t chunk_len = 0;
+
+	// First set of samples of `__samples` not yet fed.
+	uint32_t chunk_offset = 0;
+
+	// Sets of samples accepted by the current window.
+	uint32_t feed_len, dropped_len;
+
+	// Last seen value of `__adc_lost_frames`.
+	uint32_t lost_frames = 0;
+
+	// Alarm management: the alarm is on while either the power alarm or the fast trip are active.
 	bool alarm_enabled = false;
-	bool alarm_update = false;
+	bool power_alarm = false;
+	bool fast_trip = false;
+	int64_t fast_trip_timestamp_ms = 0;
 
 	/* Code */
 
+	/**
+	 * The ADC is started once and never stopped: every DMA frame is
+	 * collected as soon as it is ready, so no sample is lost between windows.
+	 */
+	ESP_ERROR_CHECK(adc_continuous_start(__adc_handle));
 	ESP_LOGI(TAG, "Sampling from ADC");
 
 	/* Infinite loop */
 	for(;;){
 		ret = ESP_OK;
 
-		// Flush old samples.
-		ESP_GOTO_ON_ERROR(
-			adc_continuous_flush_pool(__adc_handle),
+		// Read the next DMA frame once the previous one has been completely fed.
+		if(chunk_len == 0){
 
-			task_continue,
-			TAG,
-			"Error on `adc_continuous_flush_pool()`"
-		);
+			ESP_GOTO_ON_ERROR(
+				adc_continuous_read(
+					__adc_handle,
+					__buffer,
+					ADC_FRAME_SIZE_BYTES,
+					&read_len,
+					ADC_CONTINUOUS_READ_TIMEOUT_MS
+				),
 
-		// Start the sample acquisition.
-		ESP_GOTO_ON_ERROR(
-			adc_continuous_start(__adc_handle),
+				task_continue,
+				TAG,
+				"Error on `adc_continuous_read()`"
+			);
 
-			task_continue,
-			TAG,
-			"Error on `adc_continuous_start()`"
-		);
+			__pq_frame(read_len);
+
+			// One pass over the DMA frame: every channel is then a contiguous row.
+			chunk_len = __deinterleave(read_len);
+			chunk_offset = 0;
 
-		// Wait for the ISR and then clear the notification (`pdTRUE`).
-		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			// Fast overcurrent trip: checked on every DMA frame, well within a mains half-cycle.
+			if(__fast_trip_threshold > 0 && __fast_trip_check(chunk_len)){
 
-		// Read the acquired samples from the driver.
+				if(!fast_trip){
+					ESP_ERROR_CHECK_WITHOUT_ABORT(__fast_trip());
+					ESP_LOGW(TAG, "Fast overcurrent trip (> %uA peak)", CONFIG_PM_FAST_TRIP_CURRENT_A);
+				}
+
+				// The alarm is held since the last overcurrent.
+				fast_trip = true;
+				fast_trip_timestamp_ms = millis();
+			}
+		}
+
+		// The window can end in the middle of the frame: the rest is fed to the next one.
 		ESP_GOTO_ON_ERROR(
-			adc_continuous_read(
-				__adc_handle,
-				__buffer,
-				ADC_BUF_SIZE_BYTES,
-				&read_len,
-				ADC_CONTINUOUS_READ_TIMEOUT_MS
+			ul_errors_to_esp_err(
+				ul_pm_stream_feed_span(
+					__pm_handle,
+					&__samples[0][chunk_offset],
+					&__v_span,
+					&__i_span,
+					chunk_len,
+					&feed_len,
+					&dropped_len
+				)
 			),
 
 			task_continue,
 			TAG,
-			"Error on `adc_continuous_read()`"
+			"Error on `ul_pm_stream_feed_span()`"
 		);
 
-		// Stop the sample acquisition.
+		// Same samples, one circuit row at a time.
+		#if CONFIG_PM_CIRCUITS > 0
 		ESP_GOTO_ON_ERROR(
-			adc_continuous_stop(__adc_handle),
+			ul_errors_to_esp_err(
+				ul_pm_circuits_feed(
+					__pm_circuits,
+					&__samples[ADC_ROW_V][chunk_offset],
+					&__samples[ADC_ROW_CIRCUITS][chunk_offset],
+					CONFIG_PM_ADC_FRAME_SAMPLES,
+					feed_len,
+					dropped_len
+				)
+			),
 
 			task_continue,
 			TAG,
-			"Error on `adc_continuous_stop()`"
+			"Error on `ul_pm_circuits_feed()`"
 		);
+		#endif
 
-		// Sample order.
-		if(((adc_digi_output_data_t*) __buffer)[0].type1.channel == adc_channels.v_channel){
-			__v_sample_offset = 0;
-			__i_sample_offset = 1;
-		}
+		if(__capture.state == PM_CAPTURE_STATE_RUNNING)
+			__capture_append(chunk_offset, feed_len);
 
-		else {
-			__v_sample_offset = 1;
-			__i_sample_offset = 0;
-		}
+		chunk_offset += feed_len;
+		chunk_len -= feed_len;
 
-		if(xSemaphoreTake(__pm_res_mutex, pdMS_TO_TICKS(ADC_CONTINUOUS_READ_TIMEOUT_MS)) == pdFALSE)
+		// Window not complete yet.
+		if(!ul_pm_stream_window_ready(__pm_handle))
 			continue;
 
+		__capture_window_done();
+
+		// Sample coverage check.
+		if(lost_frames != __adc_lost_frames){
+			ESP_LOGW(TAG, "%lu DMA frames lost", __adc_lost_frames - lost_frames);
+			lost_frames = __adc_lost_frames;
+		}
+
+		// Merged into the medium rate before `ul_pm_stream_finalize()` resets them.
+		ul_pm_stream_aggregate(__pm_handle, &__pm_aggregates[PM_RATE_MEDIUM]);
+
+		// Evaluated on the private buffer, then published at once.
 		ESP_GOTO_ON_ERROR(
 			ul_errors_to_esp_err(
-				ul_pm_evaluate(
+				ul_pm_stream_finalize(
 					__pm_handle,
-					NULL,
-					read_len / (ADC_CHANNELS * ADC_BYTES_PER_SAMPLE),
 					&__pm_res
 				)
 			),
 
 			task_continue,
 			TAG,
-			"Error on `ul_pm_evaluate()`"
+			"Error on `ul_pm_stream_finalize()`"
 		);
 
-		xSemaphoreGive(__pm_res_mutex);
+		__seqlock_write(
+			&__pm_res_shared.seq,
+			&__pm_res_shared.res,
+			&__pm_res,
+			sizeof(ul_pm_results_t)
+		);
+
+		#if CONFIG_PM_CIRCUITS > 0
+		ESP_GOTO_ON_ERROR(
+			ul_errors_to_esp_err(
+				ul_pm_circuits_finalize(
+					__pm_circuits,
+					__pm_circuits_res
+				)
+			),
+
+			task_continue,
+			TAG,
+			"Error on `ul_pm_circuits_finalize()`"
+		);
+
+		__seqlock_write(
+			&__pm_circuits_res_shared.seq,
+			__pm_circuits_res_shared.res,
+			__pm_circuits_res,
+			sizeof(__pm_circuits_res)
+		);
+		#endif
+
+		__rates_window_done();
+
+		// Consumed by `__energy_task`, `__history_task` and `__shedding_task`: never blocks.
+		energy_add_window(&__pm_res);
+		history_add_window(&__pm_res);
+		shedding_add_window(&__pm_res);
+
+		// No mains cycles (e.g. during an interruption): the window is the detector step.
+		if(__pm_res.frequency_hz == 0)
+			__pq_cycle(__pm_res.v_rms, __pm_res.i_rms);
 
 		// Handle alarm.
 		if(
-			!alarm_enabled &&
+			!power_alarm &&
 			__pm_res.p_w >= CONFIG_PM_POWER_THRESHOLD + CONFIG_PM_POWER_HYSTERESIS
-		){
-			alarm_enabled = true;
-			alarm_update = true;
-		}
+		)
+			power_alarm = true;
 
 		else if(
-			alarm_enabled &&
+			power_alarm &&
 			__pm_res.p_w <= CONFIG_PM_POWER_THRESHOLD - CONFIG_PM_POWER_HYSTERESIS
-		){
-			alarm_enabled = false;
-			alarm_update = true;
-		}
+		)
+			power_alarm = false;
 
-		if(alarm_update){
+		if(fast_trip && millis() - fast_trip_timestamp_ms >= CONFIG_PM_FAST_TRIP_HOLD_MS)
+			fast_trip = false;
+
+		if(alarm_enabled != (power_alarm || fast_trip)){
 
 			ESP_GOTO_ON_ERROR(
-				__set_alarm(alarm_enabled),
+				__set_alarm(!alarm_enabled),
 
 				task_continue,
 				TAG,
 				"Error on `__set_alarm(state=%u)`",
-				alarm_enabled
+				!alarm_enabled
 			);
 
-			alarm_update = false;
+			alarm_enabled = !alarm_enabled;
 		}
 
 		#ifdef LOG_RESULTS
@@ -515,6 +1124,8 @@ void __pm_task(void *parameters){
 		ESP_LOGI(TAG, "  P_var: %.2f", __pm_res.p_var);
 		ESP_LOGI(TAG, "  P_pf: %.2f", __pm_res.p_pf);
 
+		ESP_LOGI(TAG, "Frequency: %.2f", __pm_res.frequency_hz);
+
 		delay(1000);
 		#endif
 
@@ -563,19 +1174,196 @@ esp_err_t pm_get_results(ul_pm_results_t *ul_pm_results){
 		"Error: library not initialized"
 	);
 
+	ESP_RETURN_ON_ERROR(
+		__seqlock_read(
+			&__pm_res_shared.seq,
+			ul_pm_results,
+			&__pm_res_shared.res,
+			sizeof(ul_pm_results_t)
+		),
+
+		TAG,
+		"Error on `__seqlock_read()`"
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t pm_get_cycle_results(ul_pm_cycle_results_t *ul_pm_cycle_results){
+	assert_param_notnull(ul_pm_cycle_results);
+
 	ESP_RETURN_ON_FALSE(
+		__is_initialized(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	ESP_RETURN_ON_ERROR(
+		__seqlock_read(
+			&__pm_cycle_res_shared.seq,
+			ul_pm_cycle_results,
+			&__pm_cycle_res_shared.res,
+			sizeof(ul_pm_cycle_results_t)
+		),
+
+		TAG,
+		"Error on `__seqlock_read()`"
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t pm_get_rate_results(pm_rate_t rate, ul_pm_aggregate_results_t *ul_pm_aggregate_results){
+	assert_param_notnull(ul_pm_aggregate_results);
+
+	ESP_RETURN_ON_FALSE(
+		rate < PM_RATES,
+
+		ESP_ERR_INVALID_ARG,
+		TAG,
+		"Error: invalid rate %u",
+		rate
+	);
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	ESP_RETURN_ON_ERROR(
+		__seqlock_read(
+			&__pm_aggregates_res_shared[rate].seq,
+			ul_pm_aggregate_results,
+			&__pm_aggregates_res_shared[rate].res,
+			sizeof(ul_pm_aggregate_results_t)
+		),
+
+		TAG,
+		"Error on `__seqlock_read()`"
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t pm_get_circuits_results(ul_pm_circuit_results_t *ul_pm_circuit_results){
+	assert_param_notnull(ul_pm_circuit_results);
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	#if CONFIG_PM_CIRCUITS > 0
+	ESP_RETURN_ON_ERROR(
+		__seqlock_read(
+			&__pm_circuits_res_shared.seq,
+			ul_pm_circuit_results,
+			__pm_circuits_res_shared.res,
+			sizeof(__pm_circuits_res_shared.res)
+		),
+
+		TAG,
+		"Error on `__seqlock_read()`"
+	);
+
+	return ESP_OK;
+
+	#else
+	return ESP_ERR_NOT_SUPPORTED;
+	#endif
+}
+
+esp_err_t pm_capture(uint8_t windows, pm_capture_header_t *header, int16_t **samples){
+	assert_param_notnull(header);
+	assert_param_notnull(samples);
+	assert_param_size_ok(windows);
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	ESP_RETURN_ON_FALSE(
+		xSemaphoreTake(__capture_mutex, 0) == pdTRUE,
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: another capture is in progress"
+	);
+
+	esp_err_t ret = ESP_OK;
+
+	if(__capture.buffer == NULL){
+		__capture.buffer = malloc(PM_CAPTURE_BUFFER_LEN_BYTES);
+
+		ESP_GOTO_ON_FALSE(
+			__capture.buffer != NULL,
+
+			ESP_ERR_NO_MEM,
+			label_error,
+			TAG,
+			"Error on `malloc(size=%u)`",
+			PM_CAPTURE_BUFFER_LEN_BYTES
+		);
+	}
+
+	// Drop a completion left by a capture that timed out.
+	xSemaphoreTake(__capture_done, 0);
+
+	__capture.windows = windows;
+	__capture.state = PM_CAPTURE_STATE_REQUESTED;
+
+	// One window to start, then the captured ones.
+	ESP_GOTO_ON_FALSE(
 		xSemaphoreTake(
-			__pm_res_mutex,
-			pdMS_TO_TICKS(ADC_CONTINUOUS_READ_TIMEOUT_MS)
+			__capture_done,
+			pdMS_TO_TICKS((windows + 2) * ADC_CONTINUOUS_READ_TIMEOUT_MS)
 		) == pdTRUE,
 
 		ESP_ERR_TIMEOUT,
+		label_error,
 		TAG,
-		"Error: unable to take `__pm_res_mutex`"
+		"Error: capture timed out"
 	);
 
-	*ul_pm_results = __pm_res;
-	xSemaphoreGive(__pm_res_mutex);
+	// Interleaved into pairs of 12-bit samples by `__capture_append()`.
+	uint32_t pairs_len = __capture.len / ADC_PAIR_SIZE_BYTES;
+	int16_t *pairs = (int16_t*) __capture.buffer;
+
+	*header = (pm_capture_header_t){
+		.version = PM_CAPTURE_VERSION,
+		.bits = 12,
+		.windows = __capture.windows_len + (__capture.truncated ? 1 : 0),
+		.truncated = __capture.truncated,
+		.sample_rate_hz = ADC_CHANNEL_SAMPLE_RATE,
+		.pairs_len = pairs_len,
+		.v_scale = __pm_handle->k_v,
+		.i_scale = __pm_handle->k_i
+	};
+
+	memcpy(header->magic, PM_CAPTURE_MAGIC, sizeof(header->magic));
+	*samples = pairs;
 
 	return ESP_OK;
+
+	label_error:
+	__capture.state = PM_CAPTURE_STATE_IDLE;
+	xSemaphoreGive(__capture_mutex);
+	return ret;
+}
+
+void pm_capture_release(){
+	__capture.state = PM_CAPTURE_STATE_IDLE;
+	xSemaphoreGive(__capture_mutex);
 }
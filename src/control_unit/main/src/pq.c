@@ -0,0 +1,575 @@
+/** @file pq.c
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+#include <pq.h>
+#include <private.h>
+
+/************************************************************************************************************
+* Private Defines
+************************************************************************************************************/
+
+#define LOG_TAG	"pq"
+
+// Events waiting to be saved.
+#define PQ_QUEUE_LEN	4
+
+// "/littlefs/pq/4294967295.bin".
+#define PQ_EVENT_PATH_LEN	(sizeof(PQ_EVENTS_FOLDER) + 16)
+
+// RMS voltage thresholds.
+#define PQ_SAG_V						(CONFIG_PQ_NOMINAL_VOLTAGE * (100 - CONFIG_PQ_SAG_PERCENT) / 100.0f)
+#define PQ_SWELL_V					(CONFIG_PQ_NOMINAL_VOLTAGE * (100 + CONFIG_PQ_SWELL_PERCENT) / 100.0f)
+#define PQ_INTERRUPTION_V		(CONFIG_PQ_NOMINAL_VOLTAGE * CONFIG_PQ_INTERRUPTION_PERCENT / 100.0f)
+#define PQ_HYSTERESIS_V			(CONFIG_PQ_NOMINAL_VOLTAGE * CONFIG_PQ_HYSTERESIS_PERCENT / 100.0f)
+
+// Weight of a new cycle on the average RMS current (1/2^n): about a second at 50Hz.
+#define PQ_I_AVG_SHIFT	6
+
+/**
+ * @brief Statement to check if the library was initialized.
+ */
+#define __is_initialized()( \
+	__pq_task_handle != NULL \
+)
+
+/************************************************************************************************************
+* Private Types Definitions
+ ************************************************************************************************************/
+
+typedef struct {
+	pq_event_t event;
+	pq_snapshot_t *snapshot;
+} pq_queue_item_t;
+
+/************************************************************************************************************
+* Private Variables
+ ************************************************************************************************************/
+
+static const char *TAG = LOG_TAG;
+
+static TaskHandle_t __pq_task_handle = NULL;
+static QueueHandle_t __pq_queue;
+
+// Next event id, restored from the saved events.
+static uint32_t __pq_next_id = 0;
+
+// Detector state, private to `__pm_task`.
+static struct {
+
+	// An event is in progress, or it ended and it was not submitted yet.
+	bool active;
+	bool ended;
+
+	pq_event_t event;
+
+	// Average RMS current outside of events, and its inrush threshold frozen at the event start.
+	float i_avg;
+	float i_inrush;
+
+} __pq_detector = {
+	.active = false,
+	.ended = false,
+	.i_avg = -1
+};
+
+/************************************************************************************************************
+* Private Functions Prototypes
+ ************************************************************************************************************/
+
+static esp_err_t __pq_task_setup();
+
+/**
+ * @brief Create the events folder, restore `__pq_next_id` and delete the events in excess.
+ */
+static esp_err_t __pq_folder_setup();
+
+/**
+ * @brief Parse the id of an event file name.
+ * @return `false` if the name is not an event file name.
+ */
+static bool __pq_parse_file_name(const char *name, uint32_t *id);
+
+/**
+ * @brief Write the event file: header, then the snapshot frames oldest first.
+ */
+static esp_err_t __pq_save(pq_event_t *event, pq_snapshot_t *snapshot);
+
+static int __pq_compare_events(const void *a, const void *b);
+
+static void __pq_task(void *parameters);
+
+/************************************************************************************************************
+* Private Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t __pq_task_setup(){
+
+	__pq_queue = xQueueCreate(PQ_QUEUE_LEN, sizeof(pq_queue_item_t));
+	ESP_RETURN_ON_FALSE(
+		__pq_queue != NULL,
+
+		ESP_ERR_NO_MEM,
+		TAG,
+		"Error: unable to allocate `__pq_queue`"
+	);
+
+	BaseType_t ret_val = xTaskCreatePinnedToCore(
+		__pq_task,
+		LOG_TAG "_task",
+		CONFIG_PQ_TASK_STACK_SIZE_BYTES,
+		NULL,
+		CONFIG_PQ_TASK_PRIORITY,
+		&__pq_task_handle,
+		CONFIG_PQ_TASK_CORE_AFFINITY
+	);
+
+	ESP_RETURN_ON_FALSE(
+		ret_val == pdPASS,
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error %d: unable to spawn \"" LOG_TAG "_task\"",
+		ret_val
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t __pq_folder_setup(){
+
+	DIR *dir;
+	struct dirent *entry;
+	char path[PQ_EVENT_PATH_LEN];
+	uint32_t id;
+	bool found = false;
+
+	if(mkdir(PQ_EVENTS_FOLDER, 0755) != 0)
+		ESP_RETURN_ON_FALSE(
+			errno == EEXIST,
+
+			ESP_FAIL,
+			TAG,
+			"Error on `mkdir(path=\"%s\")` (errno=%d)",
+			PQ_EVENTS_FOLDER, errno
+		);
+
+	dir = opendir(PQ_EVENTS_FOLDER);
+	ESP_RETURN_ON_FALSE(
+		dir != NULL,
+
+		ESP_FAIL,
+		TAG,
+		"Error on `opendir(path=\"%s\")` (errno=%d)",
+		PQ_EVENTS_FOLDER, errno
+	);
+
+	while((entry = readdir(dir)) != NULL)
+		if(__pq_parse_file_name(entry->d_name, &id) && (!found || id >= __pq_next_id)){
+			__pq_next_id = id + 1;
+			found = true;
+		}
+
+	// Only the latest `CONFIG_PQ_MAX_EVENTS` events are kept.
+	rewinddir(dir);
+
+	while((entry = readdir(dir)) != NULL)
+		if(__pq_parse_file_name(entry->d_name, &id) && __pq_next_id - id > CONFIG_PQ_MAX_EVENTS){
+			snprintf(path, sizeof(path), PQ_EVENTS_FOLDER "/%lu.bin", id);
+			unlink(path);
+		}
+
+	closedir(dir);
+
+	ESP_LOGI(TAG, "Next event id is %lu", __pq_next_id);
+	return ESP_OK;
+}
+
+bool __pq_parse_file_name(const char *name, uint32_t *id){
+	char *end;
+
+	if(name[0] < '0' || name[0] > '9')
+		return false;
+
+	*id = strtoul(name, &end, 10);
+	return strcmp(end, ".bin") == 0;
+}
+
+esp_err_t __pq_save(pq_event_t *event, pq_snapshot_t *snapshot){
+	esp_err_t ret = ESP_OK;
+
+	char path[PQ_EVENT_PATH_LEN];
+	FILE *file;
+	uint8_t frame;
+
+	snprintf(path, sizeof(path), PQ_EVENTS_FOLDER "/%lu.bin", event->id);
+
+	file = fopen(path, "wb");
+	ESP_RETURN_ON_FALSE(
+		file != NULL,
+
+		ESP_FAIL,
+		TAG,
+		"Error on `fopen(filename=\"%s\")` (errno=%d)",
+		path, errno
+	);
+
+	ESP_GOTO_ON_FALSE(
+		fwrite(event, sizeof(pq_event_t), 1, file) == 1,
+
+		ESP_FAIL,
+		label_cleanup,
+		TAG,
+		"Error on `fwrite(filename=\"%s\")` (errno=%d)",
+		path, errno
+	);
+
+	if(snapshot == NULL)
+		goto label_cleanup;
+
+	for(uint8_t i=0; i<PQ_SNAPSHOT_FRAMES; i++){
+		frame = (snapshot->head + i) % PQ_SNAPSHOT_FRAMES;
+
+		ESP_GOTO_ON_FALSE(
+			fwrite(
+				&snapshot->frames[frame * snapshot->frame_size_bytes],
+				1,
+				snapshot->frames_len[frame],
+				file
+			) == snapshot->frames_len[frame],
+
+			ESP_FAIL,
+			label_cleanup,
+			TAG,
+			"Error on `fwrite(filename=\"%s\")` (errno=%d)",
+			path, errno
+		);
+	}
+
+	label_cleanup:
+	fclose(file);
+
+	// A partial event is worse than none.
+	if(ret != ESP_OK)
+		unlink(path);
+
+	return ret;
+}
+
+int __pq_compare_events(const void *a, const void *b){
+	uint32_t id_a = ((pq_event_t*) a)->id;
+	uint32_t id_b = ((pq_event_t*) b)->id;
+
+	return (id_a > id_b) - (id_a < id_b);
+}
+
+void __pq_task(void *parameters){
+
+	ESP_LOGI(TAG, "Started");
+
+	/* Variables */
+
+	// `ESP_GOTO_ON_ERROR()` return code.
+	esp_err_t ret __attribute__((unused));
+
+	pq_queue_item_t item;
+	pq_snapshot_t *snapshot;
+	char path[PQ_EVENT_PATH_LEN];
+
+	const char *types[] = { "Sag", "Swell", "Interruption", "Inrush" };
+
+	/* Code */
+
+	/* Infinite loop */
+	for(;;){
+		ret = ESP_OK;
+
+		// Waiting for `pq_submit()`.
+		if(xQueueReceive(__pq_queue, &item, portMAX_DELAY) == pdFALSE)
+			continue;
+
+		snapshot = item.snapshot;
+		item.event.id = __pq_next_id++;
+
+		ESP_LOGW(
+			TAG, "%s #%lu: %lums, %.2f%s",
+			types[item.event.type], item.event.id, item.event.duration_ms,
+			item.event.extreme, (item.event.type == PQ_EVENT_TYPE_INRUSH ? "A" : "V")
+		);
+
+		ESP_GOTO_ON_FALSE(
+			fs_available(),
+
+			ESP_ERR_INVALID_STATE,
+			task_continue,
+			TAG,
+			"Error: filesystem not available, event #%lu not saved",
+			item.event.id
+		);
+
+		ESP_GOTO_ON_ERROR(
+			__pq_save(&item.event, snapshot),
+
+			task_continue,
+			TAG,
+			"Error on `__pq_save(id=%lu)`",
+			item.event.id
+		);
+
+		// Oldest event.
+		if(item.event.id >= CONFIG_PQ_MAX_EVENTS){
+			snprintf(path, sizeof(path), PQ_EVENTS_FOLDER "/%lu.bin", item.event.id - CONFIG_PQ_MAX_EVENTS);
+			unlink(path);
+		}
+
+		task_continue:
+
+		// The snapshot ring can be reused by `__pm_task`.
+		if(snapshot != NULL)
+			snapshot->busy = false;
+	}
+}
+
+/************************************************************************************************************
+* Public Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t pq_setup(){
+
+	// Events are still detected and logged without a filesystem.
+	if(fs_available())
+		ESP_ERROR_CHECK_WITHOUT_ABORT(__pq_folder_setup());
+
+	ESP_RETURN_ON_ERROR(
+		__pq_task_setup(),
+
+		TAG,
+		"Error on `__pq_task_setup()`"
+	);
+
+	return ESP_OK;
+}
+
+pq_detect_t pq_detect(float v_rms, float i_rms){
+
+	pq_event_t *event = &__pq_detector.event;
+	int64_t now_ms = millis();
+	float i_inrush;
+	bool ended;
+
+	// Called by `__pm_task` on every cycle: no logs here.
+	if(!__is_initialized() || __pq_detector.ended)
+		return PQ_DETECT_NONE;
+
+	/* Event in progress: track the extreme until the value is back in range, with hysteresis */
+
+	if(__pq_detector.active){
+
+		switch(event->type){
+			case PQ_EVENT_TYPE_SAG:
+			case PQ_EVENT_TYPE_INTERRUPTION:
+
+				// A sag can get worse.
+				if(v_rms < PQ_INTERRUPTION_V)
+					event->type = PQ_EVENT_TYPE_INTERRUPTION;
+
+				if(v_rms < event->extreme)
+					event->extreme = v_rms;
+
+				ended = (v_rms >= PQ_SAG_V + PQ_HYSTERESIS_V);
+				break;
+
+			case PQ_EVENT_TYPE_SWELL:
+				if(v_rms > event->extreme)
+					event->extreme = v_rms;
+
+				ended = (v_rms <= PQ_SWELL_V - PQ_HYSTERESIS_V);
+				break;
+
+			default:
+				if(i_rms > event->extreme)
+					event->extreme = i_rms;
+
+				ended = (i_rms <= __pq_detector.i_inrush * (100 - CONFIG_PQ_HYSTERESIS_PERCENT) / 100.0f);
+				break;
+		}
+
+		if(!ended)
+			return PQ_DETECT_NONE;
+
+		event->duration_ms = now_ms - event->uptime_ms;
+
+		__pq_detector.active = false;
+		__pq_detector.ended = true;
+		return PQ_DETECT_END;
+	}
+
+	/* No event in progress */
+
+	i_inrush = CONFIG_PQ_INRUSH_FACTOR * __pq_detector.i_avg;
+	if(i_inrush < CONFIG_PQ_INRUSH_CURRENT_A)
+		i_inrush = CONFIG_PQ_INRUSH_CURRENT_A;
+
+	*event = (pq_event_t){
+		.uptime_ms = now_ms,
+		.extreme = v_rms
+	};
+
+	if(v_rms < PQ_INTERRUPTION_V)
+		event->type = PQ_EVENT_TYPE_INTERRUPTION;
+
+	else if(v_rms < PQ_SAG_V)
+		event->type = PQ_EVENT_TYPE_SAG;
+
+	else if(v_rms > PQ_SWELL_V)
+		event->type = PQ_EVENT_TYPE_SWELL;
+
+	// Not before the average current is known.
+	else if(CONFIG_PQ_INRUSH_CURRENT_A > 0 && __pq_detector.i_avg >= 0 && i_rms > i_inrush){
+		event->type = PQ_EVENT_TYPE_INRUSH;
+		event->extreme = i_rms;
+		__pq_detector.i_inrush = i_inrush;
+	}
+
+	// Normal cycle.
+	else {
+		if(__pq_detector.i_avg < 0)
+			__pq_detector.i_avg = i_rms;
+
+		else
+			__pq_detector.i_avg += (i_rms - __pq_detector.i_avg) / (1 << PQ_I_AVG_SHIFT);
+
+		return PQ_DETECT_NONE;
+	}
+
+	// Wall-clock time, only once an event starts.
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+
+	if(tv.tv_sec >= CLOCK_MIN_VALID_TIME)
+		event->timestamp_ms = (int64_t) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+
+	__pq_detector.active = true;
+	return PQ_DETECT_START;
+}
+
+esp_err_t pq_submit(pq_snapshot_t *snapshot){
+
+	pq_queue_item_t item;
+
+	// Called by `__pm_task`: no logs here.
+	if(!__is_initialized() || !__pq_detector.ended)
+		return ESP_ERR_INVALID_STATE;
+
+	item = (pq_queue_item_t){
+		.event = __pq_detector.event,
+		.snapshot = snapshot
+	};
+
+	__pq_detector.ended = false;
+
+	if(snapshot != NULL){
+		item.event.sample_rate_hz = snapshot->sample_rate_hz;
+		item.event.v_scale = snapshot->v_scale;
+		item.event.i_scale = snapshot->i_scale;
+
+		for(uint8_t i=0; i<PQ_SNAPSHOT_FRAMES; i++){
+			uint16_t frame_len = snapshot->frames_len[(snapshot->head + i) % PQ_SNAPSHOT_FRAMES];
+
+			if(i < CONFIG_PQ_PRE_TRIGGER_FRAMES)
+				item.event.pre_trigger_bytes += frame_len;
+
+			item.event.snapshot_len_bytes += frame_len;
+		}
+
+		snapshot->busy = true;
+	}
+
+	if(xQueueSend(__pq_queue, &item, 0) != pdTRUE){
+		if(snapshot != NULL)
+			snapshot->busy = false;
+
+		return ESP_ERR_NO_MEM;
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t pq_get_events(pq_event_t *events, uint32_t *events_len){
+
+	DIR *dir;
+	struct dirent *entry;
+	char path[PQ_EVENT_PATH_LEN];
+	FILE *file;
+	uint32_t id, len = 0;
+
+	ESP_RETURN_ON_FALSE(
+		events != NULL && events_len != NULL,
+
+		ESP_ERR_INVALID_ARG,
+		TAG,
+		"Error: `events` and `events_len` are required"
+	);
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized() && fs_available(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized or filesystem not available"
+	);
+
+	dir = opendir(PQ_EVENTS_FOLDER);
+	ESP_RETURN_ON_FALSE(
+		dir != NULL,
+
+		ESP_FAIL,
+		TAG,
+		"Error on `opendir(path=\"%s\")` (errno=%d)",
+		PQ_EVENTS_FOLDER, errno
+	);
+
+	while(len < *events_len && (entry = readdir(dir)) != NULL){
+		if(!__pq_parse_file_name(entry->d_name, &id))
+			continue;
+
+		snprintf(path, sizeof(path), PQ_EVENTS_FOLDER "/%lu.bin", id);
+
+		// Files being written or deleted meanwhile are skipped.
+		file = fopen(path, "rb");
+		if(file == NULL)
+			continue;
+
+		if(fread(&events[len], sizeof(pq_event_t), 1, file) == 1)
+			len++;
+
+		fclose(file);
+	}
+
+	closedir(dir);
+
+	// Oldest first.
+	qsort(events, len, sizeof(pq_event_t), __pq_compare_events);
+
+	*events_len = len;
+	return ESP_OK;
+}
+
+FILE *pq_open_event(uint32_t id){
+	char path[PQ_EVENT_PATH_LEN];
+
+	if(!fs_available())
+		return NULL;
+
+	snprintf(path, sizeof(path), PQ_EVENTS_FOLDER "/%lu.bin", id);
+	return fopen(path, "rb");
+}
@@ -58,6 +58,9 @@ static const char *TAG = LOG_TAG;
 static TaskHandle_t __pwm_task_handle = NULL;
 static QueueHandle_t __pwm_queue;
 
+// Duty targets last written by `pwm_write_zone()`, by zone.
+static uint16_t __pwm_target_duties[ZONE_MAX] = { 0 };
+
 /************************************************************************************************************
 * Private Functions Prototypes
  ************************************************************************************************************/
@@ -337,5 +340,25 @@ esp_err_t pwm_write_zone(uint8_t zone, uint16_t target_duty, uint16_t fade_time_
 		"Error: `pwm_queue` is full"
 	);
 
+	__pwm_target_duties[zone] = target_duty;
+	return ESP_OK;
+}
+
+esp_err_t pwm_read_zone(uint8_t zone, uint16_t *target_duty){
+	assert_param_notnull(target_duty);
+
+	ESP_RETURN_ON_FALSE(
+		__is_initialized(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: library not initialized"
+	);
+
+	// The zone is is not a PWM zone.
+	if(!__zone_to_pwm_out(zone, NULL, NULL, NULL))
+		return ESP_ERR_NOT_SUPPORTED;
+
+	*target_duty = __pwm_target_duties[zone];
 	return ESP_OK;
 }
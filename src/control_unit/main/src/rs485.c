@@ -13,6 +13,7 @@
 
 #include <rs485.h>
 #include <private.h>
+#include <seqlock.h>
 
 /************************************************************************************************************
 * Private Defines
@@ -24,8 +25,25 @@
 // Should be greater than `UART_HW_FIFO_LEN(uart_num)`.
 #define UART_RX_BUFFER_LEN_BYTES	(UART_HW_FIFO_LEN(CONFIG_RS485_UART_PORT) * 2)
 
-// Number of wall terminals on the RS-485 bus (from 1 to 127).
-#define WALL_TERMINALS_COUNT	13
+// `__uart_event_queue` max length in number of elements.
+#define UART_EVENT_QUEUE_LEN_ELEMENTS	16
+
+// RX timeout interrupt after this many idle symbols (byte times): it delivers partial or unexpected replies.
+#define UART_RX_TOUT_SYMBOLS	2
+
+// Wall terminal reply: its device ID, then its 3 bytes states encoded in 4 bytes.
+#define WALL_TERMINAL_ID_LEN_BYTES		1
+#define WALL_TERMINAL_DATA_LEN_BYTES	4
+
+#define WALL_TERMINALS_COUNT	RS485_WALL_TERMINALS_COUNT
+
+/**
+ * "Any news?" broadcast: every wall terminal with pending states answers with its device ID, in the time slot
+ * `device_id` after the broadcast byte.
+ * Note: must match `CONFIG_RS485_BROADCAST_ID` and `CONFIG_RS485_SLOT_US` on the wall terminals `conf_const.h`.
+ */
+#define WALL_TERMINALS_BROADCAST_ID	0x7F
+#define WALL_TERMINAL_SLOT_US				1000
 
 // Max number of buttons per wall terminal.
 #define BUTTONS_MAX_NUMBER_PER_WALL_TERMINAL	3
@@ -36,6 +54,35 @@
 // Response timeout on the data exchange phase.
 #define WALL_TERMINAL_CONN_TIMEOUT_MS	100
 
+/**
+ * Learned timeouts: after this many responses, each phase of a wall terminal times out at the p99 of its own response
+ * times, times the margin, but never below the minimum nor above the global timeouts above.
+ */
+#define WALL_TERMINAL_TIMEOUT_LEARN_RESPONSES	16
+#define WALL_TERMINAL_TIMEOUT_MARGIN					2
+#define WALL_TERMINAL_TIMEOUT_MIN_US					2000
+
+// Response time histograms: bucket `i` counts the responses within `2^(i+1)`us (the last bucket collects the overflows).
+#define RESPONSE_HISTOGRAM_BUCKETS	16
+
+/**
+ * Dead-device quarantine: after this many consecutive failed polls, a wall terminal is skipped for the base time,
+ * doubled at every further failure up to the max time; then it is polled again as usual.
+ */
+#define WALL_TERMINAL_QUARANTINE_FAILURES	3
+#define WALL_TERMINAL_QUARANTINE_BASE_MS	1000
+#define WALL_TERMINAL_QUARANTINE_MAX_MS		60000
+
+// A wall terminal that sent its states within this window is active: it is polled first on each round.
+#define WALL_TERMINAL_ACTIVE_WINDOW_MS	5000
+
+// Poll-interval latency histogram: bucket width and buckets count (the last bucket collects the overflows).
+#define POLL_INTERVAL_HISTOGRAM_BUCKET_MS	10
+#define POLL_INTERVAL_HISTOGRAM_BUCKETS		128
+
+// Log the poll-interval latency percentiles every this many handled replies.
+#define POLL_INTERVAL_LOG_PERIOD_REPLIES	32
+
 // Default duty for every PWM zone.
 #define PWM_DEFAULT_VALUE	__led_gamma_correction(512)
 
@@ -78,16 +125,89 @@
 		zone, enabled, duty, device_id, trimmer_val \
 	)
 
+#if WALL_TERMINALS_COUNT > 32
+	#error The "any news?" round supports up to 32 wall terminals.
+#endif
+
 /************************************************************************************************************
 * Private Types Definitions
  ************************************************************************************************************/
 
+typedef enum {
+	RS485_PHASE_ID = 0,		// From the poll to the device ID.
+	RS485_PHASE_DATA,			// From the device ID to the last encoded states byte.
+	RS485_PHASE_MAX
+} rs485_phase_t;
+
+typedef enum {
+	RS485_STATE_WAIT_ID = 0,		// Poll sent, waiting for the device ID.
+	RS485_STATE_WAIT_DATA,			// Waiting for the encoded states.
+	RS485_STATE_WAIT_NEWS,			// Broadcast sent, collecting the pending bits until the last time slot.
+	RS485_STATE_DONE						// Reply complete.
+} rs485_state_t;
+
+/**
+ * Poll/response transaction with a wall terminal, advanced by the UART driver events.
+ */
+typedef struct {
+	rs485_state_t state;
+	uint8_t device_id;
+
+	// The current state was entered at `state_us` and expires at `deadline_us` (`micros()`).
+	int64_t state_us;
+	int64_t deadline_us;
+
+	uint8_t encoded_data[WALL_TERMINAL_DATA_LEN_BYTES];
+	uint8_t encoded_data_len;
+
+	// "Any news?" round: bit `device_id` is set if that wall terminal has pending states.
+	uint32_t pending_mask;
+
+	// "Any news?" round: some replies were garbled, so `pending_mask` is not reliable.
+	bool garbled;
+} rs485_transaction_t;
+
+/**
+ * Polling schedule of a wall terminal (`micros()` timestamps; 0 if never happened).
+ */
+typedef struct {
+	int64_t last_poll_us;				// Last "any news?" round.
+	int64_t previous_poll_us;		// The round before.
+	int64_t last_reply_us;
+
+	// Halved when a bucket saturates, so that the learned timeouts follow the wall terminal over time.
+	uint16_t response_histogram[RS485_PHASE_MAX][RESPONSE_HISTOGRAM_BUCKETS];
+	uint8_t response_count[RS485_PHASE_MAX];
+
+	// Learned timeouts; 0 until `WALL_TERMINAL_TIMEOUT_LEARN_RESPONSES` responses.
+	uint32_t timeout_us[RS485_PHASE_MAX];
+
+	// Consecutive failed polls, and quarantine end.
+	uint8_t failures;
+	int64_t quarantine_us;
+} rs485_schedule_t;
+
 /************************************************************************************************************
 * Private Variables
  ************************************************************************************************************/
 
 static const char *TAG = LOG_TAG;
 static TaskHandle_t __rs485_task_handle;
+static QueueHandle_t __uart_event_queue;
+
+// Only accessed by the rs485 task.
+static rs485_schedule_t __schedule[WALL_TERMINALS_COUNT];
+static uint32_t __poll_interval_histogram[POLL_INTERVAL_HISTOGRAM_BUCKETS];
+static uint32_t __poll_interval_count;
+
+/**
+ * Bus telemetry, updated in place by the rs485 task under a sequence lock: the sequence number is odd
+ * while an update is in progress. Readers never block the rs485 task, and the task never waits for them.
+ */
+static struct {
+	volatile uint32_t seq;
+	rs485_telemetry_t telemetry;
+} __telemetry_shared;
 
 /************************************************************************************************************
 * Private Functions Prototypes
@@ -101,6 +221,12 @@ static int8_t __zone_to_zone_index(zone_t zone, zone_t *zones_arr, uint8_t zones
 static int8_t __zone_to_digital_zone_index(zone_t zone);
 static int8_t __zone_to_pwm_zone_index(zone_t zone);
 
+/**
+ * @brief Reload `zone_enabled[zone_index]` from the output of `zone`: other tasks (e.g. `shedding.c`) may have
+ * switched it since the rs485 task last wrote it.
+ */
+static esp_err_t __zone_resync(bool *zone_enabled, uint8_t zone_index, zone_t zone);
+
 static esp_err_t __handle_button_press(bool *zone_enabled, uint16_t *zone_duty, uint8_t device_id, uint16_t button_states);
 static esp_err_t __handle_trimmer_change(bool *zone_enabled, uint16_t *zone_duty, uint8_t device_id, uint16_t trimmer_val);
 
@@ -114,6 +240,98 @@ static esp_err_t __handle_trimmer_change(bool *zone_enabled, uint16_t *zone_duty
  */
 static esp_err_t __wall_terminals_poll(uint8_t *device_id, uint16_t *trimmer_val, uint16_t *button_states);
 
+/**
+ * @brief Poll `device_id` and check its reply.
+ * @return `ESP_ERR_NOT_FOUND` if it did not answer at all.
+ */
+static esp_err_t __wall_terminal_poll(uint8_t device_id, uint16_t *trimmer_val, uint16_t *button_states);
+
+/**
+ * @brief Ask every wall terminal at once whether it has pending states ("any news?" round).
+ * @param pending_mask Bit `device_id` is set for every wall terminal to poll; all bits on a garbled round.
+ */
+static esp_err_t __wall_terminals_broadcast(uint32_t *pending_mask);
+
+/**
+ * @brief Pick the next wall terminal to poll out of `pending_mask`: the active ones first.
+ * @note Ties go round robin.
+ */
+static uint8_t __schedule_next(int64_t now_us, uint32_t pending_mask);
+
+/**
+ * @brief Account a response time of `device_id` and update its learned timeout for `phase`.
+ */
+static void __response_record(uint8_t device_id, rs485_phase_t phase, int64_t response_us);
+
+/**
+ * @return The learned timeout of `device_id` for `phase`, or the global one.
+ */
+static uint32_t __response_timeout_us(uint8_t device_id, rs485_phase_t phase);
+
+/**
+ * @brief Account the outcome of a poll of `device_id`: repeated failures put it in quarantine, with exponential backoff.
+ */
+static void __quarantine_update(uint8_t device_id, bool ok);
+
+/**
+ * @return Bit `device_id` is set for every quarantined wall terminal.
+ */
+static uint32_t __quarantine_mask(int64_t now_us);
+
+/**
+ * @return The log2 histogram bucket of `time_us`: bucket `i` holds the times in [2^i, 2^(i+1)) us.
+ */
+static uint8_t __histogram_bucket(int64_t time_us, uint8_t buckets_len);
+
+/**
+ * @brief Account an "any news?" round on the bus telemetry.
+ */
+static void __telemetry_round(bool garbled);
+
+/**
+ * @brief Account the outcome `ret` of a `__wall_terminal_poll()` on the bus telemetry.
+ */
+static void __telemetry_poll(uint8_t device_id, esp_err_t ret, bool raised, int64_t response_us);
+
+/**
+ * @brief Account a full scan on the bus telemetry.
+ */
+static void __telemetry_cycle(int64_t cycle_us);
+
+/**
+ * @brief Account the poll-interval latency of the states just applied for `device_id`, and periodically log its percentiles.
+ * @note It is the time since the previous poll of `device_id`: an upper bound of how long its new states waited on the bus.
+ * The button press itself is not timestamped, so the wall terminal debounce and the light response are not included.
+ */
+static void __poll_interval_record(uint8_t device_id);
+
+/**
+ * @return The `percent` percentile of the poll-interval latency histogram, in ms (rounded up to the bucket width).
+ */
+static uint32_t __poll_interval_percentile(uint8_t percent);
+
+/**
+ * @brief Enter `state`: arm its deadline and the RX FIFO full interrupt on the bytes it expects.
+ */
+static esp_err_t __transaction_set_state(rs485_transaction_t *transaction, rs485_state_t state);
+
+/**
+ * @brief Discard any stale byte and poll `device_id`; `WALL_TERMINALS_BROADCAST_ID` starts an "any news?" round.
+ */
+static esp_err_t __transaction_begin(rs485_transaction_t *transaction, uint8_t device_id);
+
+/**
+ * @brief Advance the transaction by one received byte.
+ */
+static esp_err_t __transaction_feed(rs485_transaction_t *transaction, uint8_t b);
+
+/**
+ * @brief Wait for the UART driver events until the transaction is done, or its current state expires.
+ * @return `ESP_ERR_TIMEOUT` on expiration: `transaction->state` tells which phase expired.
+ * @note An "any news?" round always waits for its last time slot: bad bytes and UART errors only set `transaction->garbled`.
+ */
+static esp_err_t __transaction_wait(rs485_transaction_t *transaction);
+
 static esp_err_t __uart_driver_setup();
 static esp_err_t __rs485_task_setup();
 
@@ -178,6 +396,40 @@ int8_t __zone_to_pwm_zone_index(zone_t zone){
 	return __zone_to_zone_index(zone, pwm_zones, ZONE_PWM_LEN);
 }
 
+esp_err_t __zone_resync(bool *zone_enabled, uint8_t zone_index, zone_t zone){
+
+	uint16_t duty;
+	uint8_t level;
+
+	// PWM zone: enabled while its duty is not 0.
+	if(zone_index < ZONE_PWM_LEN){
+		ESP_RETURN_ON_ERROR(
+			pwm_read_zone(zone, &duty),
+
+			TAG,
+			"Error on `pwm_read_zone(zone=%u)`",
+			zone
+		);
+
+		zone_enabled[zone_index] = (duty > 0);
+	}
+
+	// Digital zone.
+	else {
+		ESP_RETURN_ON_ERROR(
+			gpio_read_zone(zone, &level),
+
+			TAG,
+			"Error on `gpio_read_zone(zone=%u)`",
+			zone
+		);
+
+		zone_enabled[zone_index] = (level > 0);
+	}
+
+	return ESP_OK;
+}
+
 esp_err_t __handle_button_press(bool *zone_enabled, uint16_t *zone_duty, uint8_t device_id, uint16_t button_states){
 
 	ESP_RETURN_ON_FALSE(
@@ -264,6 +516,15 @@ esp_err_t __handle_button_press(bool *zone_enabled, uint16_t *zone_duty, uint8_t
 			ZONE_PWM_LEN + zone_index_digital
 		);
 
+		// A shed zone is off: a single press turns it back on.
+		ESP_RETURN_ON_ERROR(
+			__zone_resync(zone_enabled, zone_index, zone),
+
+			TAG,
+			"Error on `__zone_resync(zone=%u)`",
+			zone
+		);
+
 		// Toggle zone.
 		zone_enabled[zone_index] =
 			!zone_enabled[zone_index];
@@ -372,7 +633,15 @@ esp_err_t __handle_trimmer_change(bool *zone_enabled, uint16_t *zone_duty, uint8
 		zone
 	);
 
-	// Do not enable the zone by rotating the trimmer.
+	ESP_RETURN_ON_ERROR(
+		__zone_resync(zone_enabled, zone_index, zone),
+
+		TAG,
+		"Error on `__zone_resync(zone=%u)`",
+		zone
+	);
+
+	// Do not enable the zone by rotating the trimmer, not even a shed one.
 	if(!zone_enabled[zone_index])
 		return ESP_OK;
 
@@ -413,17 +682,81 @@ esp_err_t __handle_trimmer_change(bool *zone_enabled, uint16_t *zone_duty, uint8
 	return ESP_OK;
 }
 
-esp_err_t __wall_terminals_poll(uint8_t *device_id, uint16_t *trimmer_val, uint16_t *button_states){
+esp_err_t __transaction_set_state(rs485_transaction_t *transaction, rs485_state_t state){
 
-	// Default returned values.
-	*device_id = 0xFF;
-	*trimmer_val = *button_states = 0x0000;
+	int expected_len;
+	int64_t timeout_us;
 
-	// Slave ID increment.
-	static uint8_t poll_device_id = WALL_TERMINALS_COUNT - 1;
-	poll_device_id = (poll_device_id + 1) % WALL_TERMINALS_COUNT;
+	transaction->state = state;
+	transaction->state_us = micros();
 
-	uint8_t tmp = ul_ms_encode_master_byte(poll_device_id);
+	switch(state){
+		case RS485_STATE_WAIT_ID:
+			expected_len = WALL_TERMINAL_ID_LEN_BYTES;
+			timeout_us = __response_timeout_us(transaction->device_id, RS485_PHASE_ID);
+			break;
+
+		case RS485_STATE_WAIT_DATA:
+			expected_len = WALL_TERMINAL_DATA_LEN_BYTES;
+			timeout_us = __response_timeout_us(transaction->device_id, RS485_PHASE_DATA);
+			break;
+
+		// Every reply is a single byte; one more slot absorbs the wall terminals clock drift.
+		case RS485_STATE_WAIT_NEWS:
+			expected_len = WALL_TERMINAL_ID_LEN_BYTES;
+			timeout_us = (WALL_TERMINALS_COUNT + 1) * WALL_TERMINAL_SLOT_US;
+			break;
+
+		default:
+			return ESP_OK;
+	}
+
+	transaction->deadline_us = transaction->state_us + timeout_us;
+
+	// The RX interrupt fires the moment the last expected byte lands.
+	ESP_RETURN_ON_ERROR(
+		uart_set_rx_full_threshold(
+			CONFIG_RS485_UART_PORT,
+			expected_len
+		),
+
+		TAG,
+		"Error on `uart_set_rx_full_threshold(threshold=%d)`",
+		expected_len
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t __transaction_begin(rs485_transaction_t *transaction, uint8_t device_id){
+
+	*transaction = (rs485_transaction_t){
+		.device_id = device_id
+	};
+
+	ESP_RETURN_ON_ERROR(
+		uart_flush_input(CONFIG_RS485_UART_PORT),
+
+		TAG,
+		"Error on `uart_flush_input()`"
+	);
+
+	// Events of the discarded bytes.
+	xQueueReset(__uart_event_queue);
+
+	ESP_RETURN_ON_ERROR(
+		__transaction_set_state(
+			transaction,
+			device_id == WALL_TERMINALS_BROADCAST_ID ?
+			RS485_STATE_WAIT_NEWS :
+			RS485_STATE_WAIT_ID
+		),
+
+		TAG,
+		"Error on `__transaction_set_state()`"
+	);
+
+	uint8_t tmp = ul_ms_encode_master_byte(device_id);
 
 	// Poll the slave device.
 	ESP_RETURN_ON_FALSE(
@@ -438,113 +771,293 @@ esp_err_t __wall_terminals_poll(uint8_t *device_id, uint16_t *trimmer_val, uint1
 		"Error on `uart_write_bytes()`"
 	);
 
+	return ESP_OK;
+}
+
+esp_err_t __transaction_feed(rs485_transaction_t *transaction, uint8_t b){
+
+	switch(transaction->state){
+		case RS485_STATE_WAIT_ID:
+
+			// Invalid response.
+			ESP_RETURN_ON_FALSE(
+				ul_ms_is_slave_byte(b),
+
+				ESP_ERR_INVALID_RESPONSE,
+				TAG,
+				"Error: slave device %02u did not answer with a slave byte (0x%02x)",
+				transaction->device_id, b
+			);
+
+			// Invalid response.
+			ESP_RETURN_ON_FALSE(
+				ul_ms_decode_slave_byte(b) == transaction->device_id,
+
+				ESP_ERR_INVALID_RESPONSE,
+				TAG,
+				"Error: slave device %02u answered with different ID %02u",
+				transaction->device_id, ul_ms_decode_slave_byte(b)
+			);
+
+			__response_record(transaction->device_id, RS485_PHASE_ID, micros() - transaction->state_us);
+			return __transaction_set_state(transaction, RS485_STATE_WAIT_DATA);
+
+		case RS485_STATE_WAIT_DATA:
+			transaction->encoded_data[transaction->encoded_data_len++] = b;
+
+			if(transaction->encoded_data_len == WALL_TERMINAL_DATA_LEN_BYTES){
+				__response_record(transaction->device_id, RS485_PHASE_DATA, micros() - transaction->state_us);
+				return __transaction_set_state(transaction, RS485_STATE_DONE);
+			}
+
+			return ESP_OK;
+
+		case RS485_STATE_WAIT_NEWS:
+
+			/**
+			 * Replies garbled by a collision: the round still lasts until its last time slot,
+			 * or the later replies would land on the next poll.
+			 */
+			if(
+				!ul_ms_is_slave_byte(b) ||
+				ul_ms_decode_slave_byte(b) >= WALL_TERMINALS_COUNT
+			){
+				if(!transaction->garbled)
+					ESP_LOGE(TAG, "Error: invalid reply to the \"any news?\" broadcast (0x%02x)", b);
+
+				transaction->garbled = true;
+				return ESP_OK;
+			}
+
+			transaction->pending_mask |= 1UL << ul_ms_decode_slave_byte(b);
+			return ESP_OK;
+
+		// Trailing bytes are discarded by the next `__transaction_begin()`.
+		default:
+			return ESP_OK;
+	}
+}
+
+esp_err_t __transaction_wait(rs485_transaction_t *transaction){
+
+	uart_event_t event;
+	uint8_t buf[WALL_TERMINAL_ID_LEN_BYTES + WALL_TERMINAL_DATA_LEN_BYTES];
+	int64_t remaining_us;
 	int read_bytes;
 
-	// Wait for the response.
-	read_bytes = uart_read_bytes(
-		CONFIG_RS485_UART_PORT,
-		ul_utils_cast_to_mem(tmp),
-		1,
-		pdMS_TO_TICKS(WALL_TERMINAL_POLL_TIMEOUT_MS)
-	);
+	while(transaction->state != RS485_STATE_DONE){
+		remaining_us = transaction->deadline_us - micros();
+
+		// Rounded up to the next tick, so that a reply is never cut short.
+		if(
+			remaining_us <= 0 ||
+			xQueueReceive(
+				__uart_event_queue,
+				&event,
+				pdMS_TO_TICKS((remaining_us + 999) / 1000) + 1
+			) != pdTRUE
+		)
+			return ESP_ERR_TIMEOUT;
 
-	// Error.
-	ESP_RETURN_ON_FALSE(
-		read_bytes >= 0,
+		switch(event.type){
+			// Drained without waiting: later events may find nothing left.
+			case UART_DATA:
+				while((read_bytes = uart_read_bytes(CONFIG_RS485_UART_PORT, buf, sizeof(buf), 0)) > 0)
+					for(int i=0; i<read_bytes; i++)
+						ESP_RETURN_ON_ERROR(
+							__transaction_feed(transaction, buf[i]),
 
-		ESP_ERR_TIMEOUT,
-		TAG,
-		"Error on `uart_read_bytes()`"
-	);
+							TAG,
+							"Error on `__transaction_feed()` for slave device %02u",
+							transaction->device_id
+						);
 
-	// Timeout.
-	if(read_bytes == 0)
+				ESP_RETURN_ON_FALSE(
+					read_bytes == 0,
+
+					ESP_ERR_INVALID_STATE,
+					TAG,
+					"Error on `uart_read_bytes()` for slave device %02u",
+					transaction->device_id
+				);
+
+				break;
+
+			case UART_FIFO_OVF:
+			case UART_BUFFER_FULL:
+				ESP_LOGE(TAG, "Error: UART RX overflow while polling slave device %02u", transaction->device_id);
+
+				// The "any news?" round keeps draining its time slots.
+				if(transaction->state == RS485_STATE_WAIT_NEWS){
+					transaction->garbled = true;
+
+					ESP_RETURN_ON_ERROR(
+						uart_flush_input(CONFIG_RS485_UART_PORT),
+
+						TAG,
+						"Error on `uart_flush_input()`"
+					);
+
+					break;
+				}
+
+				return ESP_ERR_INVALID_SIZE;
+
+			case UART_BREAK:
+			case UART_FRAME_ERR:
+			case UART_PARITY_ERR:
+				ESP_LOGE(TAG, "Error: UART framing error (event=%d) from slave device %02u", event.type, transaction->device_id);
+
+				// As above.
+				if(transaction->state == RS485_STATE_WAIT_NEWS){
+					transaction->garbled = true;
+					break;
+				}
+
+				return ESP_ERR_INVALID_RESPONSE;
+
+			default:
+				break;
+		}
+	}
+
+	return ESP_OK;
+}
+
+esp_err_t __wall_terminals_poll(uint8_t *device_id, uint16_t *trimmer_val, uint16_t *button_states){
+
+	esp_err_t ret;
+
+	// Default returned values.
+	*device_id = 0xFF;
+	*trimmer_val = *button_states = 0x0000;
+
+	/**
+	 * Wall terminals still to be polled after the last "any news?" round, and the ones that actually raised their
+	 * pending bit on it (none on a garbled round).
+	 */
+	static uint32_t pending_mask = 0, raised_mask = 0;
+
+	// Full scan start.
+	static int64_t cycle_us = 0;
+
+	if(pending_mask == 0){
+		raised_mask = 0;
+		cycle_us = micros();
+
+		ret = __wall_terminals_broadcast(&pending_mask);
+		__telemetry_round(ret != ESP_OK);
+
+		ESP_RETURN_ON_ERROR(
+			ret,
+
+			TAG,
+			"Error on `__wall_terminals_broadcast()`"
+		);
+
+		raised_mask = pending_mask;
+	}
+
+	pending_mask &= ~__quarantine_mask(micros());
+
+	// Nothing to communicate.
+	if(pending_mask == 0){
+		__telemetry_cycle(micros() - cycle_us);
 		return ESP_OK;
+	}
 
-	// Invalid response.
-	ESP_RETURN_ON_FALSE(
-		ul_ms_is_slave_byte(tmp),
+	uint8_t poll_device_id = __schedule_next(micros(), pending_mask);
+	bool raised = raised_mask & (1UL << poll_device_id);
+	int64_t poll_us = micros();
 
-		ESP_ERR_INVALID_RESPONSE,
-		TAG,
-		"Error: slave device %02u did not answer with a slave byte (0x%02x)",
-		poll_device_id, tmp
-	);
+	pending_mask &= ~(1UL << poll_device_id);
 
-	// Decode the device ID.
-	uint8_t read_device_id = ul_ms_decode_slave_byte(tmp);
+	ret = __wall_terminal_poll(poll_device_id, trimmer_val, button_states);
+	__telemetry_poll(poll_device_id, ret, raised, micros() - poll_us);
 
-	// Invalid response.
-	ESP_RETURN_ON_FALSE(
-		read_device_id == poll_device_id,
+	if(pending_mask == 0)
+		__telemetry_cycle(micros() - cycle_us);
+
+	// Nothing to communicate: a silent wall terminal is a failure only if it raised its pending bit.
+	if(ret == ESP_ERR_NOT_FOUND && !raised)
+		return ESP_OK;
+
+	__quarantine_update(poll_device_id, ret == ESP_OK);
+
+	ESP_RETURN_ON_ERROR(
+		ret,
 
-		ESP_ERR_INVALID_RESPONSE,
 		TAG,
-		"Error: slave device %02u answered with different ID %02u",
-		poll_device_id, read_device_id
+		"Error on `__wall_terminal_poll()` for slave device %02u",
+		poll_device_id
 	);
 
-	// Encoded data buffer.
-	uint8_t encoded_data[4];
+	// The terminal is in use: poll it first for a while.
+	__schedule[poll_device_id].last_reply_us = micros();
 
-	// Decoded data buffer.
-	struct __attribute__((__packed__)) {
-		uint16_t trimmer_val: 10;
-		uint16_t button_states: 6;
-		uint8_t crc8;
-	} decoded_data;
+	// Returned value.
+	*device_id = poll_device_id;
 
-	// Wait for the remaining bytes.
-	read_bytes = uart_read_bytes(
-		CONFIG_RS485_UART_PORT,
-		encoded_data,
-		sizeof(encoded_data),
-		pdMS_TO_TICKS(WALL_TERMINAL_CONN_TIMEOUT_MS)
-	);
+	return ESP_OK;
+}
 
-	// Error.
-	ESP_RETURN_ON_FALSE(
-		read_bytes >= 0,
+esp_err_t __wall_terminal_poll(uint8_t device_id, uint16_t *trimmer_val, uint16_t *button_states){
+
+	esp_err_t ret;
+	rs485_transaction_t transaction;
+
+	ESP_RETURN_ON_ERROR(
+		__transaction_begin(&transaction, device_id),
 
-		ESP_ERR_TIMEOUT,
 		TAG,
-		"Error on `uart_read_bytes()` for slave device %02u",
-		poll_device_id
+		"Error on `__transaction_begin()` for slave device %02u",
+		device_id
 	);
 
+	ret = __transaction_wait(&transaction);
+
+	// No answer at all.
+	if(ret == ESP_ERR_TIMEOUT && transaction.state == RS485_STATE_WAIT_ID)
+		return ESP_ERR_NOT_FOUND;
+
 	// Timeout.
 	ESP_RETURN_ON_FALSE(
-		read_bytes > 0,
+		ret != ESP_ERR_TIMEOUT,
 
 		ESP_ERR_TIMEOUT,
 		TAG,
-		"Error: slave device %02u exceeded the prefixed %ums timeout for sending its state",
-		poll_device_id, WALL_TERMINAL_CONN_TIMEOUT_MS
+		"Error: slave device %02u exceeded its %luus timeout for sending its state",
+		device_id, __response_timeout_us(device_id, RS485_PHASE_DATA)
 	);
 
-	// Invalid response.
-	ESP_RETURN_ON_FALSE(
-		read_bytes == sizeof(encoded_data),
+	ESP_RETURN_ON_ERROR(
+		ret,
 
-		ESP_ERR_INVALID_RESPONSE,
 		TAG,
-		"Error: slave device %02u sent %u bytes; 4 expected",
-		poll_device_id, read_bytes
+		"Error on `__transaction_wait()` for slave device %02u",
+		device_id
 	);
 
+	// Decoded data buffer.
+	struct __attribute__((__packed__)) {
+		uint16_t trimmer_val: 10;
+		uint16_t button_states: 6;
+		uint8_t crc8;
+	} decoded_data;
+
 	// Decode the received bytes.
 	ESP_RETURN_ON_ERROR(
 		ul_errors_to_esp_err(
 			ul_ms_decode_slave_message(
 				ul_utils_cast_to_mem(decoded_data),
-				encoded_data,
-				sizeof(encoded_data)
+				transaction.encoded_data,
+				sizeof(transaction.encoded_data)
 			)
 		),
 
 		TAG,
 		"Error on `ul_ms_decode_slave_message()` for slave device %02u",
-		poll_device_id
+		device_id
 	);
 
 	// CRC8 computation.
@@ -558,17 +1071,317 @@ esp_err_t __wall_terminals_poll(uint8_t *device_id, uint16_t *trimmer_val, uint1
 		ESP_ERR_INVALID_CRC,
 		TAG,
 		"Error: invalid CRC8 for slave device %02u; sent CRC8 is %02u but computed CRC8 is %02u",
-		poll_device_id, decoded_data.crc8, crc8
+		device_id, decoded_data.crc8, crc8
 	);
 
 	// Returned values.
-	*device_id = poll_device_id;
 	*trimmer_val = decoded_data.trimmer_val;
 	*button_states = decoded_data.button_states;
 
 	return ESP_OK;
 }
 
+esp_err_t __wall_terminals_broadcast(uint32_t *pending_mask){
+
+	esp_err_t ret;
+	rs485_transaction_t transaction;
+	int64_t now_us = micros();
+
+	// Every wall terminal is asked.
+	for(uint8_t i=0; i < WALL_TERMINALS_COUNT; i++){
+		__schedule[i].previous_poll_us = __schedule[i].last_poll_us;
+		__schedule[i].last_poll_us = now_us;
+	}
+
+	// On errors, fall back to polling every wall terminal.
+	*pending_mask = (1UL << (WALL_TERMINALS_COUNT - 1) << 1) - 1;
+
+	ESP_RETURN_ON_ERROR(
+		__transaction_begin(&transaction, WALL_TERMINALS_BROADCAST_ID),
+
+		TAG,
+		"Error on `__transaction_begin()` for the \"any news?\" broadcast"
+	);
+
+	ret = __transaction_wait(&transaction);
+
+	// The round always ends with its last time slot, even when garbled.
+	ESP_RETURN_ON_FALSE(
+		ret == ESP_ERR_TIMEOUT,
+
+		ret,
+		TAG,
+		"Error on `__transaction_wait()` for the \"any news?\" broadcast"
+	);
+
+	// Every time slot is over: the fallback polls find a quiet bus.
+	ESP_RETURN_ON_FALSE(
+		!transaction.garbled,
+
+		ESP_ERR_INVALID_RESPONSE,
+		TAG,
+		"Error: garbled \"any news?\" round, polling every wall terminal"
+	);
+
+	*pending_mask = transaction.pending_mask;
+	return ESP_OK;
+}
+
+uint8_t __schedule_next(int64_t now_us, uint32_t pending_mask){
+
+	static uint8_t last_device_id = WALL_TERMINALS_COUNT - 1;
+
+	uint8_t device_id, next_device_id = last_device_id;
+	bool active, next_active = false, found = false;
+
+	// Starting from the terminal after the last polled one, so that ties go round robin.
+	for(uint8_t i=1; i <= WALL_TERMINALS_COUNT; i++){
+		device_id = (last_device_id + i) % WALL_TERMINALS_COUNT;
+
+		if(!(pending_mask & (1UL << device_id)))
+			continue;
+
+		active = (
+			__schedule[device_id].last_reply_us != 0 &&
+			now_us - __schedule[device_id].last_reply_us < WALL_TERMINAL_ACTIVE_WINDOW_MS * 1000
+		);
+
+		if(!found || (active && !next_active)){
+			next_device_id = device_id;
+			next_active = active;
+			found = true;
+		}
+	}
+
+	last_device_id = next_device_id;
+	return next_device_id;
+}
+
+void __response_record(uint8_t device_id, rs485_phase_t phase, int64_t response_us){
+
+	rs485_schedule_t *schedule = &__schedule[device_id];
+	uint16_t *histogram = schedule->response_histogram[phase];
+
+	uint8_t bucket = __histogram_bucket(response_us, RESPONSE_HISTOGRAM_BUCKETS);
+
+	if(histogram[bucket] == UINT16_MAX)
+		for(uint8_t i=0; i < RESPONSE_HISTOGRAM_BUCKETS; i++)
+			histogram[i] /= 2;
+
+	histogram[bucket]++;
+
+	if(schedule->response_count[phase] < WALL_TERMINAL_TIMEOUT_LEARN_RESPONSES){
+		schedule->response_count[phase]++;
+
+		if(schedule->response_count[phase] < WALL_TERMINAL_TIMEOUT_LEARN_RESPONSES)
+			return;
+	}
+
+	// p99 bucket.
+	uint32_t total_count = 0, cumulative_count = 0, rank;
+
+	for(uint8_t i=0; i < RESPONSE_HISTOGRAM_BUCKETS; i++)
+		total_count += histogram[i];
+
+	rank = (total_count * 99 + 99) / 100;
+	bucket = 0;
+
+	while(bucket < RESPONSE_HISTOGRAM_BUCKETS - 1){
+		cumulative_count += histogram[bucket];
+
+		if(cumulative_count >= rank)
+			break;
+
+		bucket++;
+	}
+
+	// Upper bound of the p99 bucket.
+	uint32_t timeout_us = (2UL << bucket) * WALL_TERMINAL_TIMEOUT_MARGIN;
+	uint32_t max_timeout_us = 1000 * (
+		phase == RS485_PHASE_ID ?
+		WALL_TERMINAL_POLL_TIMEOUT_MS :
+		WALL_TERMINAL_CONN_TIMEOUT_MS
+	);
+
+	schedule->timeout_us[phase] = (
+		timeout_us < WALL_TERMINAL_TIMEOUT_MIN_US ? WALL_TERMINAL_TIMEOUT_MIN_US :
+		timeout_us > max_timeout_us ? max_timeout_us :
+		timeout_us
+	);
+}
+
+uint32_t __response_timeout_us(uint8_t device_id, rs485_phase_t phase){
+
+	if(device_id < WALL_TERMINALS_COUNT && __schedule[device_id].timeout_us[phase] != 0)
+		return __schedule[device_id].timeout_us[phase];
+
+	return 1000 * (
+		phase == RS485_PHASE_ID ?
+		WALL_TERMINAL_POLL_TIMEOUT_MS :
+		WALL_TERMINAL_CONN_TIMEOUT_MS
+	);
+}
+
+void __quarantine_update(uint8_t device_id, bool ok){
+
+	rs485_schedule_t *schedule = &__schedule[device_id];
+
+	if(ok){
+		if(schedule->failures >= WALL_TERMINAL_QUARANTINE_FAILURES)
+			ESP_LOGI(TAG, "Slave device %02u is back after %u failed polls", device_id, schedule->failures);
+
+		schedule->failures = 0;
+		schedule->quarantine_us = 0;
+		return;
+	}
+
+	if(schedule->failures < UINT8_MAX)
+		schedule->failures++;
+
+	if(schedule->failures < WALL_TERMINAL_QUARANTINE_FAILURES)
+		return;
+
+	// Exponential backoff.
+	uint8_t shift = schedule->failures - WALL_TERMINAL_QUARANTINE_FAILURES;
+	uint32_t quarantine_ms = (
+		shift < 16 && (WALL_TERMINAL_QUARANTINE_BASE_MS << shift) < WALL_TERMINAL_QUARANTINE_MAX_MS ?
+		WALL_TERMINAL_QUARANTINE_BASE_MS << shift :
+		WALL_TERMINAL_QUARANTINE_MAX_MS
+	);
+
+	schedule->quarantine_us = micros() + quarantine_ms * 1000LL;
+
+	ESP_LOGW(
+		TAG, "Slave device %02u quarantined for %lums after %u failed polls",
+		device_id, quarantine_ms, schedule->failures
+	);
+}
+
+uint32_t __quarantine_mask(int64_t now_us){
+
+	uint32_t mask = 0;
+
+	for(uint8_t i=0; i < WALL_TERMINALS_COUNT; i++)
+		if(__schedule[i].quarantine_us > now_us)
+			mask |= 1UL << i;
+
+	return mask;
+}
+
+uint8_t __histogram_bucket(int64_t time_us, uint8_t buckets_len){
+
+	uint8_t bucket = 0;
+
+	while(bucket < buckets_len - 1 && time_us >= (2LL << bucket))
+		bucket++;
+
+	return bucket;
+}
+
+void __telemetry_round(bool garbled){
+
+	rs485_telemetry_t *telemetry = &__telemetry_shared.telemetry;
+
+	__seqlock_write_begin(&__telemetry_shared.seq);
+
+	telemetry->rounds++;
+
+	if(garbled)
+		telemetry->garbled_rounds++;
+
+	__seqlock_write_end(&__telemetry_shared.seq);
+}
+
+void __telemetry_poll(uint8_t device_id, esp_err_t ret, bool raised, int64_t response_us){
+
+	rs485_wall_terminal_telemetry_t *telemetry = &__telemetry_shared.telemetry.wall_terminals[device_id];
+
+	__seqlock_write_begin(&__telemetry_shared.seq);
+
+	telemetry->polls++;
+
+	switch(ret){
+		case ESP_OK:
+			telemetry->replies++;
+			telemetry->response_histogram[
+				__histogram_bucket(response_us, RS485_TELEMETRY_HISTOGRAM_BUCKETS)
+			]++;
+			break;
+
+		// Silent: a timeout only if it raised its pending bit.
+		case ESP_ERR_NOT_FOUND:
+			if(raised)
+				telemetry->timeouts++;
+			break;
+
+		case ESP_ERR_TIMEOUT:
+			telemetry->timeouts++;
+			break;
+
+		case ESP_ERR_INVALID_CRC:
+			telemetry->crc_errors++;
+			break;
+
+		default:
+			telemetry->framing_errors++;
+			break;
+	}
+
+	__seqlock_write_end(&__telemetry_shared.seq);
+}
+
+void __telemetry_cycle(int64_t cycle_us){
+
+	rs485_telemetry_t *telemetry = &__telemetry_shared.telemetry;
+
+	__seqlock_write_begin(&__telemetry_shared.seq);
+
+	telemetry->cycle_histogram[
+		__histogram_bucket(cycle_us, RS485_TELEMETRY_HISTOGRAM_BUCKETS)
+	]++;
+
+	__seqlock_write_end(&__telemetry_shared.seq);
+}
+
+void __poll_interval_record(uint8_t device_id){
+
+	// Never polled before: no reference instant.
+	if(__schedule[device_id].previous_poll_us == 0)
+		return;
+
+	uint32_t bucket = (micros() - __schedule[device_id].previous_poll_us) / (POLL_INTERVAL_HISTOGRAM_BUCKET_MS * 1000);
+
+	__poll_interval_histogram[
+		bucket < POLL_INTERVAL_HISTOGRAM_BUCKETS ?
+		bucket : POLL_INTERVAL_HISTOGRAM_BUCKETS - 1
+	]++;
+
+	if(++__poll_interval_count % POLL_INTERVAL_LOG_PERIOD_REPLIES == 0)
+		ESP_LOGI(
+			TAG, "Poll-interval latency over %lu replies: p50=%lums, p99=%lums",
+			__poll_interval_count, __poll_interval_percentile(50), __poll_interval_percentile(99)
+		);
+}
+
+uint32_t __poll_interval_percentile(uint8_t percent){
+
+	// Rank of the percentile sample, rounded up.
+	uint32_t rank = ((uint64_t) __poll_interval_count * percent + 99) / 100;
+	uint32_t cumulative_count = 0;
+	uint8_t i = 0;
+
+	while(i < POLL_INTERVAL_HISTOGRAM_BUCKETS - 1){
+		cumulative_count += __poll_interval_histogram[i];
+
+		if(cumulative_count >= rank)
+			break;
+
+		i++;
+	}
+
+	return (i + 1) * POLL_INTERVAL_HISTOGRAM_BUCKET_MS;
+}
+
 esp_err_t __uart_driver_setup(){
 
 	uart_config_t uart_config = {
@@ -586,8 +1399,8 @@ esp_err_t __uart_driver_setup(){
 			CONFIG_RS485_UART_PORT,
 			UART_RX_BUFFER_LEN_BYTES,
 			0,
-			0,
-			NULL,
+			UART_EVENT_QUEUE_LEN_ELEMENTS,
+			&__uart_event_queue,
 			0
 		),
 
@@ -628,6 +1441,17 @@ esp_err_t __uart_driver_setup(){
 		"Error on `uart_set_mode()`"
 	);
 
+	// A reply is delivered as soon as it ends, instead of the default 10 symbols later.
+	ESP_RETURN_ON_ERROR(
+		uart_set_rx_timeout(
+			CONFIG_RS485_UART_PORT,
+			UART_RX_TOUT_SYMBOLS
+		),
+
+		TAG,
+		"Error on `uart_set_rx_timeout()`"
+	);
+
 	return ESP_OK;
 }
 
@@ -687,10 +1511,7 @@ void __rs485_task(void *parameters){
 	for(;;){
 		ret = ESP_OK;
 
-		// Yield task to the scheduler.
-		delay(1);
-
-		// Poll the wall terminals.
+		// Poll the wall terminals: the task sleeps on the UART events meanwhile.
 		ESP_GOTO_ON_ERROR(
 			__wall_terminals_poll(&device_id, &trimmer_val, &button_states),
 
@@ -737,6 +1558,7 @@ void __rs485_task(void *parameters){
 				device_id, trimmer_val
 			);
 
+		__poll_interval_record(device_id);
 		continue;
 		task_error:
 		ESP_ERROR_CHECK_WITHOUT_ABORT(uart_flush(CONFIG_RS485_UART_PORT));
@@ -765,3 +1587,21 @@ esp_err_t rs485_setup(){
 
 	return ESP_OK;
 }
+
+esp_err_t rs485_get_telemetry(rs485_telemetry_t *telemetry){
+	assert_param_notnull(telemetry);
+
+	ESP_RETURN_ON_ERROR(
+		__seqlock_read(
+			&__telemetry_shared.seq,
+			telemetry,
+			&__telemetry_shared.telemetry,
+			sizeof(rs485_telemetry_t)
+		),
+
+		TAG,
+		"Error: the bus telemetry is being updated too often to be read"
+	);
+
+	return ESP_OK;
+}
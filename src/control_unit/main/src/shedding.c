@@ -0,0 +1,376 @@
+/** @file shedding.c
+ *  @brief  Created on: Oct 16, 2026
+ *          Davide Scalisi
+ *
+ * @copyright [2024] Davide Scalisi *
+ * @copyright All Rights Reserved. *
+ *
+*/
+
+/************************************************************************************************************
+* Included files
+************************************************************************************************************/
+
+#include <shedding.h>
+#include <private.h>
+
+/************************************************************************************************************
+* Private Defines
+************************************************************************************************************/
+
+#define LOG_TAG	"shedding"
+
+// Fade time of dimmed and restored PWM zones.
+#define SHEDDING_PWM_FADE_TIME_MS	500
+
+/**
+ * @brief Statement to check if the library was initialized.
+ */
+#define __is_initialized()( \
+	__shedding_task_handle != NULL \
+)
+
+/************************************************************************************************************
+* Private Types Definitions
+ ************************************************************************************************************/
+
+typedef struct {
+
+	// `ZONE_SHEDDING_ZONES` item.
+	zone_t zone;
+
+	// The zone is a PWM zone, otherwise it is a digital one.
+	bool pwm;
+
+	// Level or duty target before and after being shed.
+	uint16_t saved_value;
+	uint16_t shed_value;
+
+} shedding_stage_t;
+
+/************************************************************************************************************
+* Private Variables
+ ************************************************************************************************************/
+
+static const char *TAG = LOG_TAG;
+
+static TaskHandle_t __shedding_task_handle = NULL;
+
+// Single element mailbox: only the latest `p_w` matters.
+static QueueHandle_t __shedding_queue;
+
+// Shed stages, in `ZONE_SHEDDING_ZONES` order.
+static shedding_stage_t __shedding_stages[ZONE_SHEDDING_LEN];
+static uint8_t __shedding_stages_len = 0;
+
+/************************************************************************************************************
+* Private Functions Prototypes
+ ************************************************************************************************************/
+
+static esp_err_t __shedding_task_setup();
+
+/**
+ * @brief Shed the zone `ZONE_SHEDDING_ZONES[i]`.
+ * @return `ESP_ERR_NOT_FINISHED` if the zone was already off (or dimmed), so nothing changed.
+ */
+static esp_err_t __shed(uint8_t i);
+
+/**
+ * @brief Restore the zone of `__shedding_stages[i]`, unless it was changed since it was shed.
+ * @return `ESP_ERR_NOT_FINISHED` if the zone was skipped by `__shed()`, so there is nothing to restore.
+ */
+static esp_err_t __restore(uint8_t i);
+
+static void __shedding_task(void *parameters);
+
+/************************************************************************************************************
+* Private Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t __shedding_task_setup(){
+
+	__shedding_queue = xQueueCreate(1, sizeof(float));
+	ESP_RETURN_ON_FALSE(
+		__shedding_queue != NULL,
+
+		ESP_ERR_NO_MEM,
+		TAG,
+		"Error: unable to allocate `__shedding_queue`"
+	);
+
+	BaseType_t ret_val = xTaskCreatePinnedToCore(
+		__shedding_task,
+		LOG_TAG "_task",
+		CONFIG_SHEDDING_TASK_STACK_SIZE_BYTES,
+		NULL,
+		CONFIG_SHEDDING_TASK_PRIORITY,
+		&__shedding_task_handle,
+		CONFIG_SHEDDING_TASK_CORE_AFFINITY
+	);
+
+	ESP_RETURN_ON_FALSE(
+		ret_val == pdPASS,
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error %d: unable to spawn \"" LOG_TAG "_task\"",
+		ret_val
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t __shed(uint8_t i){
+
+	zone_t zones[] = ZONE_SHEDDING_ZONES;
+	uint16_t duties[] = ZONE_SHEDDING_DUTIES;
+
+	shedding_stage_t *stage = &__shedding_stages[i];
+	uint8_t level;
+
+	*stage = (shedding_stage_t){
+		.zone = zones[i],
+		.pwm = false,
+		.shed_value = 0
+	};
+
+	// Digital zone.
+	esp_err_t ret = gpio_read_zone(stage->zone, &level);
+	if(ret == ESP_OK){
+		stage->saved_value = level;
+
+		if(level == 0)
+			return ESP_ERR_NOT_FINISHED;
+
+		ESP_RETURN_ON_ERROR(
+			gpio_write_zone(stage->zone, 0),
+
+			TAG,
+			"Error on `gpio_write_zone(zone=%u, level=0)`",
+			stage->zone
+		);
+
+		return ESP_OK;
+	}
+
+	ESP_RETURN_ON_FALSE(
+		ret == ESP_ERR_NOT_SUPPORTED,
+
+		ret,
+		TAG,
+		"Error on `gpio_read_zone(zone=%u)`",
+		stage->zone
+	);
+
+	// PWM zone.
+	stage->pwm = true;
+	stage->shed_value = duties[i];
+
+	ESP_RETURN_ON_ERROR(
+		pwm_read_zone(stage->zone, &stage->saved_value),
+
+		TAG,
+		"Error on `pwm_read_zone(zone=%u)`",
+		stage->zone
+	);
+
+	if(stage->saved_value <= stage->shed_value)
+		return ESP_ERR_NOT_FINISHED;
+
+	ESP_RETURN_ON_ERROR(
+		pwm_write_zone(stage->zone, stage->shed_value, SHEDDING_PWM_FADE_TIME_MS),
+
+		TAG,
+		"Error on `pwm_write_zone(zone=%u, target_duty=%u)`",
+		stage->zone, stage->shed_value
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t __restore(uint8_t i){
+
+	shedding_stage_t *stage = &__shedding_stages[i];
+	uint8_t level;
+	uint16_t duty;
+
+	if(!stage->pwm){
+		ESP_RETURN_ON_ERROR(
+			gpio_read_zone(stage->zone, &level),
+
+			TAG,
+			"Error on `gpio_read_zone(zone=%u)`",
+			stage->zone
+		);
+
+		// Never turned off.
+		if(stage->saved_value == 0)
+			return ESP_ERR_NOT_FINISHED;
+
+		// Turned on again by someone else.
+		if(level != stage->shed_value)
+			return ESP_OK;
+
+		ESP_RETURN_ON_ERROR(
+			gpio_write_zone(stage->zone, stage->saved_value),
+
+			TAG,
+			"Error on `gpio_write_zone(zone=%u, level=%u)`",
+			stage->zone, stage->saved_value
+		);
+
+		return ESP_OK;
+	}
+
+	ESP_RETURN_ON_ERROR(
+		pwm_read_zone(stage->zone, &duty),
+
+		TAG,
+		"Error on `pwm_read_zone(zone=%u)`",
+		stage->zone
+	);
+
+	// Never dimmed.
+	if(stage->saved_value <= stage->shed_value)
+		return ESP_ERR_NOT_FINISHED;
+
+	// Changed by someone else.
+	if(duty != stage->shed_value)
+		return ESP_OK;
+
+	ESP_RETURN_ON_ERROR(
+		pwm_write_zone(stage->zone, stage->saved_value, SHEDDING_PWM_FADE_TIME_MS),
+
+		TAG,
+		"Error on `pwm_write_zone(zone=%u, target_duty=%u)`",
+		stage->zone, stage->saved_value
+	);
+
+	return ESP_OK;
+}
+
+void __shedding_task(void *parameters){
+
+	ESP_LOGI(TAG, "Started");
+
+	/* Variables */
+
+	// `ESP_GOTO_ON_ERROR()` return code.
+	esp_err_t ret __attribute__((unused));
+
+	// Latest window active power.
+	float p_w;
+
+	// Timestamps of the last shed or restored zone and of the last window over budget.
+	int64_t last_action_ms = -CONFIG_SHEDDING_STEP_MS;
+	int64_t last_over_budget_ms = 0;
+	int64_t now_ms;
+
+	/* Code */
+
+	/* Infinite loop */
+	for(;;){
+		ret = ESP_OK;
+
+		// Waiting for `shedding_add_window()`.
+		if(xQueueReceive(__shedding_queue, &p_w, portMAX_DELAY) == pdFALSE)
+			continue;
+
+		now_ms = millis();
+
+		/* Over budget: shed the next zone right away, then one zone every step */
+
+		if(p_w > CONFIG_SHEDDING_BUDGET_W){
+			last_over_budget_ms = now_ms;
+
+			if(
+				__shedding_stages_len == ZONE_SHEDDING_LEN ||
+				now_ms - last_action_ms < CONFIG_SHEDDING_STEP_MS
+			)
+				continue;
+
+			// Zones already off are skipped: they would not lower the consumption.
+			do {
+				ret = __shed(__shedding_stages_len++);
+			} while(ret == ESP_ERR_NOT_FINISHED && __shedding_stages_len < ZONE_SHEDDING_LEN);
+
+			last_action_ms = now_ms;
+
+			ESP_GOTO_ON_ERROR(
+				ret == ESP_ERR_NOT_FINISHED ? ESP_OK : ret,
+
+				task_continue,
+				TAG,
+				"Error on `__shed(i=%u)`",
+				__shedding_stages_len - 1
+			);
+
+			if(ret == ESP_OK)
+				ESP_LOGW(
+					TAG, "%.0fW over a %uW budget: zone %u shed",
+					p_w, CONFIG_SHEDDING_BUDGET_W, __shedding_stages[__shedding_stages_len - 1].zone
+				);
+
+			continue;
+		}
+
+		/* Back under budget: restore the zones in reverse order, with hysteresis */
+
+		if(
+			__shedding_stages_len == 0 ||
+			p_w > CONFIG_SHEDDING_BUDGET_W - CONFIG_SHEDDING_HYSTERESIS_W ||
+			now_ms - last_over_budget_ms < CONFIG_SHEDDING_RESTORE_DELAY_MS ||
+			now_ms - last_action_ms < CONFIG_SHEDDING_RESTORE_DELAY_MS
+		)
+			continue;
+
+		// Zones skipped by `__shed()` are passed over within the same step.
+		do {
+			ret = __restore(--__shedding_stages_len);
+		} while(ret == ESP_ERR_NOT_FINISHED && __shedding_stages_len > 0);
+
+		last_action_ms = now_ms;
+
+		ESP_GOTO_ON_ERROR(
+			ret == ESP_ERR_NOT_FINISHED ? ESP_OK : ret,
+
+			task_continue,
+			TAG,
+			"Error on `__restore(i=%u)`",
+			__shedding_stages_len
+		);
+
+		if(ret == ESP_OK)
+			ESP_LOGI(TAG, "%.0fW: zone %u restored", p_w, __shedding_stages[__shedding_stages_len].zone);
+
+		task_continue:
+	}
+}
+
+/************************************************************************************************************
+* Public Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t shedding_setup(){
+
+	ESP_RETURN_ON_ERROR(
+		__shedding_task_setup(),
+
+		TAG,
+		"Error on `__shedding_task_setup()`"
+	);
+
+	return ESP_OK;
+}
+
+esp_err_t shedding_add_window(ul_pm_results_t *ul_pm_results){
+
+	// Called by `__pm_task` on every window: no logs here.
+	if(!__is_initialized() || ul_pm_results == NULL)
+		return ESP_ERR_INVALID_STATE;
+
+	float p_w = ul_pm_results->p_w;
+
+	xQueueOverwrite(__shedding_queue, &p_w);
+	return ESP_OK;
+}
@@ -38,13 +38,37 @@
 
 #define ROUTE_ROOT_REDIRECT		"/monitor.html"
 
+// Points sent per HTTP chunk by `__route_pm_history()`.
+#define ROUTE_PM_HISTORY_CHUNK_POINTS	32
+
+// Bytes sent per HTTP chunk by `__route_pm_capture()`.
+#define ROUTE_PM_CAPTURE_CHUNK_LEN_BYTES	1024
+
+// Bytes sent per HTTP chunk by `__route_pq_event()`.
+#define ROUTE_PQ_EVENT_CHUNK_LEN_BYTES	1024
+
+// Longest `__route_pm_history()` point: "[-32767,-32767,-32767,-3276.7,-3276.7,-3276.7],".
+#define ROUTE_PM_HISTORY_POINT_LEN_BYTES	48
+
 // Webserver routes.
 #define ROUTES	{ \
 	__route("/",		HTTP_GET,	__route_root), \
 	__route("/pm",	HTTP_GET,	__route_pm), \
+	__route("/pm/history",	HTTP_GET,	__route_pm_history), \
+	__route("/pm/capture",	HTTP_GET,	__route_pm_capture), \
+	__route("/energy",	HTTP_GET,	__route_energy), \
+	__route("/energy/reset",	HTTP_POST,	__route_energy_reset), \
+	__route("/demand",	HTTP_GET,	__route_demand), \
+	__route("/pq/events",	HTTP_GET,	__route_pq_events), \
+	__route("/pq/event",	HTTP_GET,	__route_pq_event), \
+	__route("/rs485",	HTTP_GET,	__route_rs485), \
 	__route("/*",		HTTP_GET,	__route_send_text_file), \
 }
 
+#define ROUTES_LEN	( \
+	sizeof((httpd_uri_t[]) ROUTES) / sizeof(httpd_uri_t) \
+)
+
 /************************************************************************************************************
 * Private Types Definitions
  ************************************************************************************************************/
@@ -80,13 +104,73 @@ static char *__decimals(float x);
  * @brief Encode `*res` to a dynamically allocated JSON string.
  * @note You must manually `free()` the returned string.
  */
-static char *__encode_pm_json(ul_pm_results_t *res);
+static char *__encode_pm_json(ul_pm_results_t *res, ul_pm_cycle_results_t *cycle_res, ul_pm_aggregate_results_t *rates_res, ul_pm_circuit_results_t *circuits_res);
+
+/**
+ * @brief Encode `*counters` to a dynamically allocated JSON string.
+ * @note You must manually `free()` the returned string.
+ */
+static char *__encode_energy_json(energy_counters_t *counters);
+
+/**
+ * @brief Encode `*status` to a dynamically allocated JSON string.
+ * @note You must manually `free()` the returned string.
+ */
+static char *__encode_demand_json(demand_status_t *status);
+
+/**
+ * @brief Add the `date`, `w` and `time` fields of a demand peak to `parent` as `name`.
+ */
+static void __add_demand_peak_json(cJSON *parent, const char *name, uint32_t date, demand_peak_t *peak);
+
+/**
+ * @brief Encode `events` to a dynamically allocated JSON string.
+ * @note You must manually `free()` the returned string.
+ */
+static char *__encode_pq_events_json(pq_event_t *events, uint32_t events_len);
+
+/**
+ * @brief Encode `*telemetry` to a dynamically allocated JSON string.
+ * @return `NULL` if out of memory.
+ * @note You must manually `free()` the returned string.
+ */
+static char *__encode_rs485_json(rs485_telemetry_t *telemetry);
+
+/**
+ * @brief Add `histogram` to `parent` as the `name` array.
+ */
+static void __add_histogram_json(cJSON *parent, const char *name, uint32_t *histogram, uint8_t histogram_len);
 
 /**
  * @brief Send the requested file from VFS.
  */
 static esp_err_t __route_send_text_file(httpd_req_t *req);
 static esp_err_t __route_pm(httpd_req_t *req);
+
+/**
+ * @brief Stream a history tier (`?tier=0` is the finest and the default) as JSON,
+ * oldest point first, without building the whole document in RAM.
+ */
+static esp_err_t __route_pm_history(httpd_req_t *req);
+
+/**
+ * @brief Capture the next `?windows=1` windows and stream them as `pm_capture_header_t` and raw samples.
+ */
+static esp_err_t __route_pm_capture(httpd_req_t *req);
+static esp_err_t __route_energy(httpd_req_t *req);
+static esp_err_t __route_energy_reset(httpd_req_t *req);
+static esp_err_t __route_demand(httpd_req_t *req);
+static esp_err_t __route_pq_events(httpd_req_t *req);
+
+/**
+ * @brief Send the `?id=` power-quality event file, as `pq_event_t` and raw samples.
+ */
+static esp_err_t __route_pq_event(httpd_req_t *req);
+
+/**
+ * @brief Send the RS-485 bus telemetry: per wall terminal counters and response times, and the full scan times.
+ */
+static esp_err_t __route_rs485(httpd_req_t *req);
 static esp_err_t __route_root(httpd_req_t *req);
 
 /************************************************************************************************************
@@ -222,7 +306,7 @@ char *__decimals(float x){
 	return str;
 }
 
-char *__encode_pm_json(ul_pm_results_t *res){
+char *__encode_pm_json(ul_pm_results_t *res, ul_pm_cycle_results_t *cycle_res, ul_pm_aggregate_results_t *rates_res, ul_pm_circuit_results_t *circuits_res){
 	cJSON *root = cJSON_CreateObject();
 
 	cJSON *v = cJSON_CreateObject();
@@ -246,6 +330,74 @@ char *__encode_pm_json(ul_pm_results_t *res){
 	cJSON_AddStringToObject(p, "pf", __decimals(res->p_pf));
 	cJSON_AddItemToObject(root, "p", p);
 
+	cJSON_AddStringToObject(root, "f", __decimals(res->frequency_hz));
+
+	#ifdef UL_CONFIG_PM_HARMONICS
+
+	// Harmonics from the fundamental: RMS and phase relative to the voltage fundamental.
+	cJSON *h = cJSON_CreateObject();
+	cJSON *v_h = cJSON_CreateArray();
+	cJSON *i_h = cJSON_CreateArray();
+	cJSON *item;
+
+	for(uint8_t k=0; k<UL_CONFIG_PM_HARMONICS; k++){
+		item = cJSON_CreateObject();
+		cJSON_AddStringToObject(item, "rms", __decimals(res->v_harmonics_rms[k]));
+		cJSON_AddStringToObject(item, "ph", __decimals(res->v_harmonics_phase[k]));
+		cJSON_AddItemToArray(v_h, item);
+
+		item = cJSON_CreateObject();
+		cJSON_AddStringToObject(item, "rms", __decimals(res->i_harmonics_rms[k]));
+		cJSON_AddStringToObject(item, "ph", __decimals(res->i_harmonics_phase[k]));
+		cJSON_AddItemToArray(i_h, item);
+	}
+
+	cJSON_AddItemToObject(h, "v", v_h);
+	cJSON_AddItemToObject(h, "i", i_h);
+	cJSON_AddStringToObject(h, "v_thd", __decimals(res->v_thd));
+	cJSON_AddStringToObject(h, "i_thd", __decimals(res->i_thd));
+	cJSON_AddItemToObject(root, "h", h);
+
+	#endif
+
+	// Latest mains cycle.
+	cJSON *cycle = cJSON_CreateObject();
+	cJSON_AddStringToObject(cycle, "f", __decimals(cycle_res->frequency_hz));
+	cJSON_AddStringToObject(cycle, "v_rms", __decimals(cycle_res->v_rms));
+	cJSON_AddStringToObject(cycle, "i_rms", __decimals(cycle_res->i_rms));
+	cJSON_AddStringToObject(cycle, "w", __decimals(cycle_res->p_w));
+	cJSON_AddItemToObject(root, "cycle", cycle);
+
+	// Latest medium and slow rate periods.
+	const char *rates[] = { "medium", "slow" };
+
+	for(uint8_t r=0; r<PM_RATES; r++){
+		cJSON *rate = cJSON_CreateObject();
+		cJSON_AddStringToObject(rate, "f", __decimals(rates_res[r].frequency_hz));
+		cJSON_AddStringToObject(rate, "v_rms", __decimals(rates_res[r].v_rms));
+		cJSON_AddStringToObject(rate, "i_rms", __decimals(rates_res[r].i_rms));
+		cJSON_AddStringToObject(rate, "va", __decimals(rates_res[r].p_va));
+		cJSON_AddStringToObject(rate, "w", __decimals(rates_res[r].p_w));
+		cJSON_AddStringToObject(rate, "var", __decimals(rates_res[r].p_var));
+		cJSON_AddStringToObject(rate, "pf", __decimals(rates_res[r].p_pf));
+		cJSON_AddItemToObject(root, rates[r], rate);
+	}
+
+	// Sub-metered circuits.
+	cJSON *circuits = cJSON_CreateArray();
+
+	for(uint8_t c=0; c<PM_CIRCUITS; c++){
+		cJSON *circuit = cJSON_CreateObject();
+		cJSON_AddStringToObject(circuit, "i_rms", __decimals(circuits_res[c].i_rms));
+		cJSON_AddStringToObject(circuit, "va", __decimals(circuits_res[c].p_va));
+		cJSON_AddStringToObject(circuit, "w", __decimals(circuits_res[c].p_w));
+		cJSON_AddStringToObject(circuit, "var", __decimals(circuits_res[c].p_var));
+		cJSON_AddStringToObject(circuit, "pf", __decimals(circuits_res[c].p_pf));
+		cJSON_AddItemToArray(circuits, circuit);
+	}
+
+	cJSON_AddItemToObject(root, "circuits", circuits);
+
 	char *json = cJSON_Print(root);
 
 	// Free root with every appended child.
@@ -254,6 +406,115 @@ char *__encode_pm_json(ul_pm_results_t *res){
 	return json;
 }
 
+char *__encode_energy_json(energy_counters_t *counters){
+	cJSON *root = cJSON_CreateObject();
+
+	cJSON_AddStringToObject(root, "wh_import", __decimals(counters->wh_import));
+	cJSON_AddStringToObject(root, "wh_export", __decimals(counters->wh_export));
+	cJSON_AddStringToObject(root, "varh", __decimals(counters->varh));
+
+	char *json = cJSON_Print(root);
+	cJSON_Delete(root);
+
+	return json;
+}
+
+char *__encode_demand_json(demand_status_t *status){
+	cJSON *root = cJSON_CreateObject();
+
+	cJSON_AddStringToObject(root, "w", __decimals(status->p_w));
+	cJSON_AddBoolToObject(root, "partial", status->partial);
+	cJSON_AddBoolToObject(root, "clock_synced", status->clock_synced);
+
+	__add_demand_peak_json(root, "day", status->peaks.day, &status->peaks.day_peak);
+	__add_demand_peak_json(root, "month", status->peaks.month, &status->peaks.month_peak);
+	__add_demand_peak_json(root, "last_month", status->peaks.last_month, &status->peaks.last_month_peak);
+
+	char *json = cJSON_Print(root);
+	cJSON_Delete(root);
+
+	return json;
+}
+
+void __add_demand_peak_json(cJSON *parent, const char *name, uint32_t date, demand_peak_t *peak){
+	cJSON *item = cJSON_CreateObject();
+
+	// `YYYYMMDD` or `YYYYMM`, and Unix time.
+	cJSON_AddNumberToObject(item, "date", date);
+	cJSON_AddStringToObject(item, "w", __decimals(peak->p_w));
+	cJSON_AddNumberToObject(item, "time", peak->timestamp);
+	cJSON_AddItemToObject(parent, name, item);
+}
+
+char *__encode_pq_events_json(pq_event_t *events, uint32_t events_len){
+	const char *types[] = { "sag", "swell", "interruption", "inrush" };
+	cJSON *root = cJSON_CreateArray();
+
+	for(uint32_t i=0; i<events_len; i++){
+		cJSON *event = cJSON_CreateObject();
+
+		cJSON_AddNumberToObject(event, "id", events[i].id);
+		cJSON_AddStringToObject(event, "type", types[events[i].type]);
+		cJSON_AddNumberToObject(event, "timestamp_ms", events[i].timestamp_ms);
+		cJSON_AddNumberToObject(event, "uptime_ms", events[i].uptime_ms);
+		cJSON_AddNumberToObject(event, "duration_ms", events[i].duration_ms);
+		cJSON_AddStringToObject(event, "extreme", __decimals(events[i].extreme));
+		cJSON_AddNumberToObject(event, "snapshot_len_bytes", events[i].snapshot_len_bytes);
+		cJSON_AddItemToArray(root, event);
+	}
+
+	char *json = cJSON_Print(root);
+	cJSON_Delete(root);
+
+	return json;
+}
+
+char *__encode_rs485_json(rs485_telemetry_t *telemetry){
+	cJSON *root = cJSON_CreateObject();
+	cJSON *wall_terminals = cJSON_CreateArray();
+
+	cJSON_AddNumberToObject(root, "rounds", telemetry->rounds);
+	cJSON_AddNumberToObject(root, "garbled_rounds", telemetry->garbled_rounds);
+	__add_histogram_json(root, "cycle_us", telemetry->cycle_histogram, RS485_TELEMETRY_HISTOGRAM_BUCKETS);
+
+	for(uint8_t i=0; i<RS485_WALL_TERMINALS_COUNT; i++){
+		rs485_wall_terminal_telemetry_t *wall_terminal_telemetry = &telemetry->wall_terminals[i];
+		cJSON *wall_terminal = cJSON_CreateObject();
+
+		cJSON_AddNumberToObject(wall_terminal, "id", i);
+		cJSON_AddNumberToObject(wall_terminal, "polls", wall_terminal_telemetry->polls);
+		cJSON_AddNumberToObject(wall_terminal, "replies", wall_terminal_telemetry->replies);
+		cJSON_AddNumberToObject(wall_terminal, "timeouts", wall_terminal_telemetry->timeouts);
+		cJSON_AddNumberToObject(wall_terminal, "crc_errors", wall_terminal_telemetry->crc_errors);
+		cJSON_AddNumberToObject(wall_terminal, "framing_errors", wall_terminal_telemetry->framing_errors);
+
+		__add_histogram_json(
+			wall_terminal, "response_us",
+			wall_terminal_telemetry->response_histogram,
+			RS485_TELEMETRY_HISTOGRAM_BUCKETS
+		);
+
+		cJSON_AddItemToArray(wall_terminals, wall_terminal);
+	}
+
+	cJSON_AddItemToObject(root, "wall_terminals", wall_terminals);
+
+	char *json = cJSON_Print(root);
+	cJSON_Delete(root);
+
+	return json;
+}
+
+void __add_histogram_json(cJSON *parent, const char *name, uint32_t *histogram, uint8_t histogram_len){
+	cJSON *array = cJSON_CreateArray();
+
+	// Bucket `i` counts the times within `2^(i+1)`us.
+	for(uint8_t i=0; i<histogram_len; i++)
+		cJSON_AddItemToArray(array, cJSON_CreateNumber(histogram[i]));
+
+	cJSON_AddItemToObject(parent, name, array);
+}
+
 esp_err_t __route_send_text_file(httpd_req_t *req){
 	esp_err_t ret = ESP_OK;
 	__log_http_request(req);
@@ -348,6 +609,10 @@ esp_err_t __route_pm(httpd_req_t *req){
 	esp_err_t ret = ESP_OK;
 
 	ul_pm_results_t res;
+	ul_pm_cycle_results_t cycle_res;
+	ul_pm_aggregate_results_t rates_res[PM_RATES];
+	// One more item: never a zero-length array.
+	ul_pm_circuit_results_t circuits_res[PM_CIRCUITS + 1];
 	char *json = NULL;
 
 	ESP_GOTO_ON_ERROR(
@@ -358,7 +623,34 @@ esp_err_t __route_pm(httpd_req_t *req){
 		"Error on `pm_get_results()`"
 	);
 
-	json = __encode_pm_json(&res);
+	ESP_GOTO_ON_ERROR(
+		pm_get_cycle_results(&cycle_res),
+
+		label_error_500,
+		TAG,
+		"Error on `pm_get_cycle_results()`"
+	);
+
+	for(uint8_t r=0; r<PM_RATES; r++)
+		ESP_GOTO_ON_ERROR(
+			pm_get_rate_results(r, &rates_res[r]),
+
+			label_error_500,
+			TAG,
+			"Error on `pm_get_rate_results(rate=%u)`",
+			r
+		);
+
+	if(PM_CIRCUITS > 0)
+		ESP_GOTO_ON_ERROR(
+			pm_get_circuits_results(circuits_res),
+
+			label_error_500,
+			TAG,
+			"Error on `pm_get_circuits_results()`"
+		);
+
+	json = __encode_pm_json(&res, &cycle_res, rates_res, circuits_res);
 	ESP_GOTO_ON_ERROR(
 		httpd_resp_set_type(
 			req, HTTPD_TYPE_JSON
@@ -388,77 +680,689 @@ esp_err_t __route_pm(httpd_req_t *req){
 	goto label_cleanup;
 }
 
-esp_err_t __route_root(httpd_req_t *req){
+esp_err_t __route_pm_history(httpd_req_t *req){
 	esp_err_t ret = ESP_OK;
 
+	uint8_t tier = 0;
+	history_tier_info_t info;
+
+	history_point_t points[ROUTE_PM_HISTORY_CHUNK_POINTS];
+	uint32_t points_len;
+	uint32_t next;
+
+	char *buffer = NULL;
+	uint32_t buffer_len;
+
+	{
+		decoded_uri_t uri = __decode_uri(req);
+		char value[CONFIG_WEBSERVER_QUERY_VAL_BUFFER_LEN_BYTES];
+
+		if(
+			uri.query_len > 0 &&
+			httpd_query_key_value(uri.query, "tier", value, sizeof(value)) == ESP_OK
+		)
+			tier = strtoul(value, NULL, 10);
+	}
+
+	ESP_GOTO_ON_FALSE(
+		tier < HISTORY_TIERS,
+
+		ESP_ERR_INVALID_ARG,
+		label_error_400,
+		TAG,
+		"Error: tier %u does not exist",
+		tier
+	);
+
 	ESP_GOTO_ON_ERROR(
-		httpd_resp_set_status(
-			req, "302 Found"
+		history_get_tier_info(tier, &info),
+
+		label_error_500,
+		TAG,
+		"Error on `history_get_tier_info(tier=%u)`",
+		tier
+	);
+
+	buffer = malloc(ROUTE_PM_HISTORY_CHUNK_POINTS * ROUTE_PM_HISTORY_POINT_LEN_BYTES + 1);
+	ESP_GOTO_ON_FALSE(
+		buffer != NULL,
+
+		ESP_ERR_NO_MEM,
+		label_error_500,
+		TAG,
+		"Error on `malloc()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_set_type(
+			req, HTTPD_TYPE_JSON
 		),
 
-		label_error,
+		label_error_500,
 		TAG,
-		"Error on `httpd_resp_set_status()`"
+		"Error on `httpd_resp_set_type()`"
+	);
+
+	snprintf(
+		buffer, ROUTE_PM_HISTORY_CHUNK_POINTS * ROUTE_PM_HISTORY_POINT_LEN_BYTES,
+		"{\"tier\":%u,\"period_s\":%lu,\"end_s\":%lu,\"uptime_s\":%lu,"
+		"\"fields\":[\"p_min\",\"p_avg\",\"p_max\",\"v_min\",\"v_avg\",\"v_max\"],"
+		"\"points\":[",
+		tier, info.period_s, info.end_s, (uint32_t) (micros() / 1000000)
 	);
 
 	ESP_GOTO_ON_ERROR(
-		httpd_resp_set_hdr(
-			req,
-			"Location",
-			ROUTE_ROOT_REDIRECT
+		httpd_resp_sendstr_chunk(
+			req, buffer
 		),
 
-		label_error,
+		label_cleanup,
 		TAG,
-		"Error on `httpd_resp_set_hdr()`"
+		"Error on `httpd_resp_sendstr_chunk()`"
+	);
+
+	// Only the points stored when the request arrived: newer ones would shift `end_s`.
+	next = info.pushed - info.count;
+
+	while(next < info.pushed){
+		points_len = info.pushed - next;
+		if(points_len > ROUTE_PM_HISTORY_CHUNK_POINTS)
+			points_len = ROUTE_PM_HISTORY_CHUNK_POINTS;
+
+		ESP_GOTO_ON_ERROR(
+			history_read(tier, next, points, &points_len),
+
+			label_cleanup,
+			TAG,
+			"Error on `history_read(tier=%u, first=%lu)`",
+			tier, next
+		);
+
+		buffer_len = 0;
+
+		for(uint32_t i=0; i<points_len; i++){
+			const char *separator = (next + i + 1 < info.pushed ? "," : "");
+
+			if(points[i].p_avg == HISTORY_NO_DATA)
+				buffer_len += sprintf(&buffer[buffer_len], "null%s", separator);
+
+			else
+				buffer_len += sprintf(
+					&buffer[buffer_len],
+					"[%d,%d,%d,%.1f,%.1f,%.1f]%s",
+					points[i].p_min / HISTORY_P_SCALE,
+					points[i].p_avg / HISTORY_P_SCALE,
+					points[i].p_max / HISTORY_P_SCALE,
+					(float) points[i].v_min / HISTORY_V_SCALE,
+					(float) points[i].v_avg / HISTORY_V_SCALE,
+					(float) points[i].v_max / HISTORY_V_SCALE,
+					separator
+				);
+		}
+
+		ESP_GOTO_ON_ERROR(
+			httpd_resp_send_chunk(
+				req, buffer, buffer_len
+			),
+
+			label_cleanup,
+			TAG,
+			"Error on `httpd_resp_send_chunk()`"
+		);
+
+		next += points_len;
+	}
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_sendstr_chunk(
+			req, "]}"
+		),
+
+		label_cleanup,
+		TAG,
+		"Error on `httpd_resp_sendstr_chunk()`"
 	);
 
 	ESP_GOTO_ON_ERROR(
-		httpd_resp_send(
-			req, NULL, 0
+		httpd_resp_sendstr_chunk(
+			req, NULL
 		),
 
-		label_error,
+		label_cleanup,
 		TAG,
-		"Error on `httpd_resp_send()`"
+		"Error on `httpd_resp_sendstr_chunk(str=NULL)`"
 	);
 
+	label_cleanup:
+	free(buffer);
 	return ret;
 
-	label_error:
+	label_error_400:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, NULL));
+	goto label_cleanup;
+
+	label_error_500:
 	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_500(req));
-	return ret;
+	goto label_cleanup;
 }
 
-/************************************************************************************************************
-* Public Functions Definitions
- ************************************************************************************************************/
+esp_err_t __route_pm_capture(httpd_req_t *req){
+	esp_err_t ret = ESP_OK;
+	__log_http_request(req);
 
-esp_err_t webserver_setup(){
+	uint32_t windows = 1;
+	pm_capture_header_t header;
+	int16_t *samples;
 
-	ESP_RETURN_ON_FALSE(
-		wifi_network_available(),
+	bool captured = false;
+	uint32_t len, sent;
 
-		ESP_ERR_INVALID_STATE,
+	{
+		decoded_uri_t uri = __decode_uri(req);
+		char value[CONFIG_WEBSERVER_QUERY_VAL_BUFFER_LEN_BYTES];
+
+		if(
+			uri.query_len > 0 &&
+			httpd_query_key_value(uri.query, "windows", value, sizeof(value)) == ESP_OK
+		)
+			windows = strtoul(value, NULL, 10);
+	}
+
+	ESP_GOTO_ON_FALSE(
+		ul_utils_between(windows, 1, UINT8_MAX),
+
+		ESP_ERR_INVALID_ARG,
+		label_error_400,
 		TAG,
-		"Error: network service not available"
+		"Error: invalid number of windows (%lu)",
+		windows
 	);
 
-	ESP_RETURN_ON_FALSE(
-		fs_available(),
+	ESP_GOTO_ON_ERROR(
+		pm_capture(windows, &header, &samples),
 
-		ESP_ERR_INVALID_STATE,
+		label_error_500,
 		TAG,
-		"Error: filesystem service not initialized"
+		"Error on `pm_capture(windows=%lu)`",
+		windows
 	);
 
-	// Webserver daemon configurations.
-	httpd_config_t webserver_config = HTTPD_DEFAULT_CONFIG();
+	captured = true;
 
-	webserver_config.stack_size = CONFIG_WEBSERVER_MAIN_TASK_STACK_SIZE_BYTES;
-	webserver_config.task_priority = CONFIG_WEBSERVER_MAIN_TASK_PRIORITY;
-	webserver_config.core_id = CONFIG_WEBSERVER_MAIN_TASK_CORE_AFFINITY;
-	webserver_config.server_port = CONFIG_WEBSERVER_LISTEN_PORT;
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_set_type(
+			req, "application/octet-stream"
+		),
+
+		label_error_500,
+		TAG,
+		"Error on `httpd_resp_set_type()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_send_chunk(
+			req, (char*) &header, sizeof(header)
+		),
+
+		label_cleanup,
+		TAG,
+		"Error on `httpd_resp_send_chunk()`"
+	);
+
+	// Straight from the capture buffer.
+	len = header.pairs_len * 2 * sizeof(int16_t);
+
+	for(sent=0; sent<len; sent+=ROUTE_PM_CAPTURE_CHUNK_LEN_BYTES)
+		ESP_GOTO_ON_ERROR(
+			httpd_resp_send_chunk(
+				req,
+				&((char*) samples)[sent],
+				(len - sent > ROUTE_PM_CAPTURE_CHUNK_LEN_BYTES ? ROUTE_PM_CAPTURE_CHUNK_LEN_BYTES : len - sent)
+			),
+
+			label_cleanup,
+			TAG,
+			"Error on `httpd_resp_send_chunk(offset=%lu)`",
+			sent
+		);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_send_chunk(
+			req, NULL, 0
+		),
+
+		label_cleanup,
+		TAG,
+		"Error on `httpd_resp_send_chunk(NULL)`"
+	);
+
+	label_cleanup:
+	if(captured)
+		pm_capture_release();
+
+	return ret;
+
+	label_error_400:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, NULL));
+	goto label_cleanup;
+
+	label_error_500:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_500(req));
+	goto label_cleanup;
+}
+
+esp_err_t __route_energy(httpd_req_t *req){
+	esp_err_t ret = ESP_OK;
+
+	energy_counters_t counters;
+	char *json = NULL;
+
+	ESP_GOTO_ON_ERROR(
+		energy_get_counters(&counters),
+
+		label_error_500,
+		TAG,
+		"Error on `energy_get_counters()`"
+	);
+
+	json = __encode_energy_json(&counters);
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_set_type(
+			req, HTTPD_TYPE_JSON
+		),
+
+		label_error_500,
+		TAG,
+		"Error on `httpd_resp_set_type()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_sendstr(
+			req, json
+		),
+
+		label_error_500,
+		TAG,
+		"Error on `httpd_resp_send()`"
+	);
+
+	label_cleanup:
+	free(json);
+	return ret;
+
+	label_error_500:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_500(req));
+	goto label_cleanup;
+}
+
+esp_err_t __route_demand(httpd_req_t *req){
+	esp_err_t ret = ESP_OK;
+
+	demand_status_t status;
+	char *json = NULL;
+
+	ESP_GOTO_ON_ERROR(
+		demand_get_status(&status),
+
+		label_error_500,
+		TAG,
+		"Error on `demand_get_status()`"
+	);
+
+	json = __encode_demand_json(&status);
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_set_type(
+			req, HTTPD_TYPE_JSON
+		),
+
+		label_error_500,
+		TAG,
+		"Error on `httpd_resp_set_type()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_sendstr(
+			req, json
+		),
+
+		label_error_500,
+		TAG,
+		"Error on `httpd_resp_send()`"
+	);
+
+	label_cleanup:
+	free(json);
+	return ret;
+
+	label_error_500:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_500(req));
+	goto label_cleanup;
+}
+
+esp_err_t __route_energy_reset(httpd_req_t *req){
+	esp_err_t ret = ESP_OK;
+	__log_http_request(req);
+
+	ESP_GOTO_ON_ERROR(
+		energy_reset(),
+
+		label_error,
+		TAG,
+		"Error on `energy_reset()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_send(
+			req, NULL, 0
+		),
+
+		label_error,
+		TAG,
+		"Error on `httpd_resp_send()`"
+	);
+
+	return ret;
+
+	label_error:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_500(req));
+	return ret;
+}
+
+esp_err_t __route_pq_events(httpd_req_t *req){
+	esp_err_t ret = ESP_OK;
+
+	pq_event_t *events = NULL;
+	uint32_t events_len = CONFIG_PQ_MAX_EVENTS;
+	char *json = NULL;
+
+	events = malloc(CONFIG_PQ_MAX_EVENTS * sizeof(pq_event_t));
+	ESP_GOTO_ON_FALSE(
+		events != NULL,
+
+		ESP_ERR_NO_MEM,
+		label_error_500,
+		TAG,
+		"Error on `malloc()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		pq_get_events(events, &events_len),
+
+		label_error_500,
+		TAG,
+		"Error on `pq_get_events()`"
+	);
+
+	json = __encode_pq_events_json(events, events_len);
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_set_type(
+			req, HTTPD_TYPE_JSON
+		),
+
+		label_error_500,
+		TAG,
+		"Error on `httpd_resp_set_type()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_sendstr(
+			req, json
+		),
+
+		label_error_500,
+		TAG,
+		"Error on `httpd_resp_send()`"
+	);
+
+	label_cleanup:
+	free(json);
+	free(events);
+	return ret;
+
+	label_error_500:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_500(req));
+	goto label_cleanup;
+}
+
+esp_err_t __route_pq_event(httpd_req_t *req){
+	esp_err_t ret = ESP_OK;
+	__log_http_request(req);
+
+	char value[CONFIG_WEBSERVER_QUERY_VAL_BUFFER_LEN_BYTES];
+	char *buffer = NULL;
+	FILE *file = NULL;
+	uint32_t id;
+	size_t len;
+
+	{
+		decoded_uri_t uri = __decode_uri(req);
+
+		ESP_GOTO_ON_FALSE(
+			uri.query_len > 0 &&
+			httpd_query_key_value(uri.query, "id", value, sizeof(value)) == ESP_OK,
+
+			ESP_ERR_INVALID_ARG,
+			label_error_400,
+			TAG,
+			"Error: missing event id"
+		);
+
+		id = strtoul(value, NULL, 10);
+	}
+
+	file = pq_open_event(id);
+	ESP_GOTO_ON_FALSE(
+		file != NULL,
+
+		ESP_ERR_NOT_FOUND,
+		label_error_404,
+		TAG,
+		"Error on `pq_open_event(id=%lu)`",
+		id
+	);
+
+	buffer = malloc(ROUTE_PQ_EVENT_CHUNK_LEN_BYTES);
+	ESP_GOTO_ON_FALSE(
+		buffer != NULL,
+
+		ESP_ERR_NO_MEM,
+		label_error_500,
+		TAG,
+		"Error on `malloc(size=%u)`",
+		ROUTE_PQ_EVENT_CHUNK_LEN_BYTES
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_set_type(
+			req, "application/octet-stream"
+		),
+
+		label_error_500,
+		TAG,
+		"Error on `httpd_resp_set_type()`"
+	);
+
+	while((len = fread(buffer, 1, ROUTE_PQ_EVENT_CHUNK_LEN_BYTES, file)) > 0)
+		ESP_GOTO_ON_ERROR(
+			httpd_resp_send_chunk(
+				req, buffer, len
+			),
+
+			label_cleanup,
+			TAG,
+			"Error on `httpd_resp_send_chunk()`"
+		);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_send_chunk(
+			req, NULL, 0
+		),
+
+		label_cleanup,
+		TAG,
+		"Error on `httpd_resp_send_chunk(NULL)`"
+	);
+
+	label_cleanup:
+	free(buffer);
+
+	if(file != NULL)
+		fclose(file);
+
+	return ret;
+
+	label_error_400:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, NULL));
+	goto label_cleanup;
+
+	label_error_404:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_404(req));
+	goto label_cleanup;
+
+	label_error_500:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_500(req));
+	goto label_cleanup;
+}
+
+esp_err_t __route_rs485(httpd_req_t *req){
+	esp_err_t ret = ESP_OK;
+	__log_http_request(req);
+
+	rs485_telemetry_t *telemetry = NULL;
+	char *json = NULL;
+
+	telemetry = malloc(sizeof(rs485_telemetry_t));
+	ESP_GOTO_ON_FALSE(
+		telemetry != NULL,
+
+		ESP_ERR_NO_MEM,
+		label_error_500,
+		TAG,
+		"Error on `malloc()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		rs485_get_telemetry(telemetry),
+
+		label_error_500,
+		TAG,
+		"Error on `rs485_get_telemetry()`"
+	);
+
+	json = __encode_rs485_json(telemetry);
+	ESP_GOTO_ON_FALSE(
+		json != NULL,
+
+		ESP_ERR_NO_MEM,
+		label_error_500,
+		TAG,
+		"Error on `__encode_rs485_json()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_set_type(
+			req, HTTPD_TYPE_JSON
+		),
+
+		label_error_500,
+		TAG,
+		"Error on `httpd_resp_set_type()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_sendstr(
+			req, json
+		),
+
+		label_error_500,
+		TAG,
+		"Error on `httpd_resp_send()`"
+	);
+
+	label_cleanup:
+	free(json);
+	free(telemetry);
+	return ret;
+
+	label_error_500:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_500(req));
+	goto label_cleanup;
+}
+
+esp_err_t __route_root(httpd_req_t *req){
+	esp_err_t ret = ESP_OK;
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_set_status(
+			req, "302 Found"
+		),
+
+		label_error,
+		TAG,
+		"Error on `httpd_resp_set_status()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_set_hdr(
+			req,
+			"Location",
+			ROUTE_ROOT_REDIRECT
+		),
+
+		label_error,
+		TAG,
+		"Error on `httpd_resp_set_hdr()`"
+	);
+
+	ESP_GOTO_ON_ERROR(
+		httpd_resp_send(
+			req, NULL, 0
+		),
+
+		label_error,
+		TAG,
+		"Error on `httpd_resp_send()`"
+	);
+
+	return ret;
+
+	label_error:
+	ESP_ERROR_CHECK_WITHOUT_ABORT(httpd_resp_send_500(req));
+	return ret;
+}
+
+/************************************************************************************************************
+* Public Functions Definitions
+ ************************************************************************************************************/
+
+esp_err_t webserver_setup(){
+
+	ESP_RETURN_ON_FALSE(
+		wifi_network_available(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: network service not available"
+	);
+
+	ESP_RETURN_ON_FALSE(
+		fs_available(),
+
+		ESP_ERR_INVALID_STATE,
+		TAG,
+		"Error: filesystem service not initialized"
+	);
+
+	// Webserver daemon configurations.
+	httpd_config_t webserver_config = HTTPD_DEFAULT_CONFIG();
+
+	webserver_config.stack_size = CONFIG_WEBSERVER_MAIN_TASK_STACK_SIZE_BYTES;
+	webserver_config.task_priority = CONFIG_WEBSERVER_MAIN_TASK_PRIORITY;
+	webserver_config.core_id = CONFIG_WEBSERVER_MAIN_TASK_CORE_AFFINITY;
+	webserver_config.server_port = CONFIG_WEBSERVER_LISTEN_PORT;
+
+	// One URI handler slot for each route.
+	webserver_config.max_uri_handlers = ROUTES_LEN;
 
 	/**
 	 * Use the URI wildcard matching function in order to
@@ -27,6 +27,10 @@
 // UART
 #define CONFIG_UART_TX_MODE_DELAY_US	50		// Microseconds to stabilize the RS-485 bus after pulling high the DE/~RE pin.
 
+// RS-485 "any news?" broadcast (must match the control unit `rs485.c`).
+#define CONFIG_RS485_BROADCAST_ID			0x7F	// Master byte asking every wall terminal whether it has pending states.
+#define CONFIG_RS485_SLOT_US					1000	// Reply time slot width: each wall terminal answers `CONFIG_RS485_DEVICE_ID` slots after the broadcast.
+
 // Timings
 #define CONFIG_TIME_BTN_DEBOUNCER_MS	200		// Button delay time after pressed.
 #define CONFIG_TIME_BTN_HELD_TICKS		5			// At this number of ticks, the button will be considered held; the minimum hold time is `CONFIG_HOLD_BTN_TICKS` * `CONFIG_TIME_BTN_DEBOUNCER_MS`.
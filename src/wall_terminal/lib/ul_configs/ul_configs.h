@@ -35,8 +35,21 @@
 * ul_crc.h
 ************************************************************************************************************/
 
+#define UL_CONFIG_CRC_TABLE_SIZE						16		// Comment to compute the CRCs bit by bit; otherwise, lookup tables entries (256: fastest, 16: smallest).
+
 #define UL_CONFIG_CRC_CRC8_POLYNOMIAL				0x07		// Standard CRC8 configurations.
 #define UL_CONFIG_CRC8_INITIAL_VALUE				0x00
 #define UL_CONFIG_CRC_CRC8_FINAL_XOR_VALUE	0x00
+// #define UL_CONFIG_CRC_CRC8_REFLECTED								// Uncomment for reflected (LSB first) CRCs: the polynomial must be reversed too.
+
+// #define UL_CONFIG_CRC_CRC16_POLYNOMIAL				0xA001		// CRC-16/MODBUS configurations; comment to disable the CRC-16.
+// #define UL_CONFIG_CRC_CRC16_INITIAL_VALUE			0xFFFF
+// #define UL_CONFIG_CRC_CRC16_FINAL_XOR_VALUE		0x0000
+// #define UL_CONFIG_CRC_CRC16_REFLECTED
+
+// #define UL_CONFIG_CRC_CRC32_POLYNOMIAL				0xEDB88320	// CRC-32 (ISO-HDLC) configurations; comment to disable the CRC-32.
+// #define UL_CONFIG_CRC_CRC32_INITIAL_VALUE			0xFFFFFFFF
+// #define UL_CONFIG_CRC_CRC32_FINAL_XOR_VALUE		0xFFFFFFFF
+// #define UL_CONFIG_CRC_CRC32_REFLECTED
 
 #endif  /* INC_UL_CONFIGS_H_ */
@@ -14,10 +14,99 @@
 #include <ul_crc.h>
 #include <ul_private.h>
 
+// Lookup tables are kept on flash on the AVRs.
+#if defined(UL_CONFIG_CRC_TABLE_SIZE) && defined(__AVR__)
+#include <avr/pgmspace.h>
+#endif
+
 /************************************************************************************************************
 * Private Defines
 ************************************************************************************************************/
 
+#ifdef UL_CONFIG_CRC_CRC8_REFLECTED
+#define CRC8_REFLECTED	1
+#else
+#define CRC8_REFLECTED	0
+#endif
+
+#ifdef UL_CONFIG_CRC_CRC16_REFLECTED
+#define CRC16_REFLECTED	1
+#else
+#define CRC16_REFLECTED	0
+#endif
+
+#ifdef UL_CONFIG_CRC_CRC32_REFLECTED
+#define CRC32_REFLECTED	1
+#else
+#define CRC32_REFLECTED	0
+#endif
+
+#ifdef __AVR__
+#define __crc_table_attr	PROGMEM
+#define __crc_table_read(table, i)( \
+	sizeof((table)[0]) == 1 ? pgm_read_byte(&(table)[i]) : \
+	sizeof((table)[0]) == 2 ? pgm_read_word(&(table)[i]) : \
+	pgm_read_dword(&(table)[i]) \
+)
+#else
+#define __crc_table_attr
+#define __crc_table_read(table, i)	((table)[i])
+#endif
+
+/**
+ * @brief Fold the byte `b` into the `width` bits CRC register `crc` (a variable of the exact width type).
+ * @note All the other parameters are constants, so the unused branches are removed by the compiler.
+ */
+#if UL_CONFIG_CRC_TABLE_SIZE == 256
+#define __crc_fold_byte(crc, b, width, reflected, polynomial, table){ \
+	crc = ( \
+		reflected ? \
+		(crc >> 8) ^ __crc_table_read(table, (uint8_t) (crc ^ (b))) : \
+		(crc << 8) ^ __crc_table_read(table, (uint8_t) ((crc >> ((width) - 8)) ^ (b))) \
+	); \
+}
+
+#elif UL_CONFIG_CRC_TABLE_SIZE == 16
+#define __crc_fold_nibble(crc, n, width, reflected, table){ \
+	crc = ( \
+		reflected ? \
+		(crc >> 4) ^ __crc_table_read(table, (crc ^ (n)) & 0x0F) : \
+		(crc << 4) ^ __crc_table_read(table, ((crc >> ((width) - 4)) ^ (n)) & 0x0F) \
+	); \
+}
+
+// Reflected CRCs take the low nibble first.
+#define __crc_fold_byte(crc, b, width, reflected, polynomial, table){ \
+	__crc_fold_nibble(crc, (reflected ? (b) : (b) >> 4), width, reflected, table); \
+	__crc_fold_nibble(crc, (reflected ? (b) >> 4 : (b)), width, reflected, table); \
+}
+
+#else
+#define __crc_fold_byte(crc, b, width, reflected, polynomial, table){ \
+	if(reflected){ \
+		crc ^= (b); \
+		\
+		for(uint8_t bit=0; bit<8; bit++) \
+			crc = ( \
+				crc & 1 ? \
+				(crc >> 1) ^ (polynomial) : \
+				crc >> 1 \
+			); \
+	} \
+	\
+	else { \
+		crc ^= (__typeof__(crc)) (b) << ((width) - 8); \
+		\
+		for(uint8_t bit=0; bit<8; bit++) \
+			crc = ( \
+				(crc >> ((width) - 1)) & 1 ? \
+				(crc << 1) ^ (polynomial) : \
+				crc << 1 \
+			); \
+	} \
+}
+#endif
+
 /************************************************************************************************************
 * Private Types Definitions
  ************************************************************************************************************/
@@ -26,6 +115,38 @@
 * Private Variables
  ************************************************************************************************************/
 
+/**
+ * Lookup tables, generated at compile time from the `ul_configs.h` polynomials.
+ */
+#ifdef UL_CONFIG_CRC_TABLE_SIZE
+
+#define __CRC_TABLE				__crc8_table
+#define __CRC_TYPE				uint8_t
+#define __CRC_WIDTH				8
+#define __CRC_POLYNOMIAL	UL_CONFIG_CRC_CRC8_POLYNOMIAL
+#define __CRC_REFLECTED		CRC8_REFLECTED
+#include "ul_crc_table.h"
+
+#ifdef UL_CONFIG_CRC_CRC16_POLYNOMIAL
+#define __CRC_TABLE				__crc16_table
+#define __CRC_TYPE				uint16_t
+#define __CRC_WIDTH				16
+#define __CRC_POLYNOMIAL	UL_CONFIG_CRC_CRC16_POLYNOMIAL
+#define __CRC_REFLECTED		CRC16_REFLECTED
+#include "ul_crc_table.h"
+#endif
+
+#ifdef UL_CONFIG_CRC_CRC32_POLYNOMIAL
+#define __CRC_TABLE				__crc32_table
+#define __CRC_TYPE				uint32_t
+#define __CRC_WIDTH				32
+#define __CRC_POLYNOMIAL	UL_CONFIG_CRC_CRC32_POLYNOMIAL
+#define __CRC_REFLECTED		CRC32_REFLECTED
+#include "ul_crc_table.h"
+#endif
+
+#endif
+
 /************************************************************************************************************
 * Private Functions Prototypes
  ************************************************************************************************************/
@@ -46,18 +167,70 @@ uint8_t ul_crc_crc8(const uint8_t *data, uint32_t len){
 	)
 		return 0x00;
 
-	uint8_t bit, crc = UL_CONFIG_CRC8_INITIAL_VALUE;
+	return ul_crc_crc8_final(
+		ul_crc_crc8_update(ul_crc_crc8_init(), data, len)
+	);
+}
+
+uint8_t ul_crc_crc8_update(uint8_t crc, const uint8_t *data, uint32_t len){
+
+	if(data == NULL)
+		return crc;
+
+	for(uint32_t i=0; i<len; i++)
+		__crc_fold_byte(crc, data[i], 8, CRC8_REFLECTED, UL_CONFIG_CRC_CRC8_POLYNOMIAL, __crc8_table);
+
+	return crc;
+}
+
+#ifdef UL_CONFIG_CRC_CRC16_POLYNOMIAL
+uint16_t ul_crc_crc16(const uint8_t *data, uint32_t len){
+
+	if(
+		data == NULL ||
+		len == 0
+	)
+		return 0x0000;
+
+	return ul_crc_crc16_final(
+		ul_crc_crc16_update(ul_crc_crc16_init(), data, len)
+	);
+}
+
+uint16_t ul_crc_crc16_update(uint16_t crc, const uint8_t *data, uint32_t len){
+
+	if(data == NULL)
+		return crc;
+
+	for(uint32_t i=0; i<len; i++)
+		__crc_fold_byte(crc, data[i], 16, CRC16_REFLECTED, UL_CONFIG_CRC_CRC16_POLYNOMIAL, __crc16_table);
+
+	return crc;
+}
+#endif
+
+#ifdef UL_CONFIG_CRC_CRC32_POLYNOMIAL
+uint32_t ul_crc_crc32(const uint8_t *data, uint32_t len){
+
+	if(
+		data == NULL ||
+		len == 0
+	)
+		return 0x00000000;
+
+	return ul_crc_crc32_final(
+		ul_crc_crc32_update(ul_crc_crc32_init(), data, len)
+	);
+}
+
+uint32_t ul_crc_crc32_update(uint32_t crc, const uint8_t *data, uint32_t len){
 
-	for(uint32_t i=0; i<len; i++){
-		crc ^= data[i];
+	if(data == NULL)
+		return crc;
 
-		for(bit=0; bit<8; bit++)
-			crc = (
-				crc & 0x80 ?
-				(crc << 1) ^ UL_CONFIG_CRC_CRC8_POLYNOMIAL :
-				crc << 1
-			);
-	}
+	for(uint32_t i=0; i<len; i++)
+		__crc_fold_byte(crc, data[i], 32, CRC32_REFLECTED, UL_CONFIG_CRC_CRC32_POLYNOMIAL, __crc32_table);
 
-	return (crc ^ UL_CONFIG_CRC_CRC8_FINAL_XOR_VALUE);
+	return crc;
 }
+#endif
@@ -41,6 +41,44 @@
 	ul_crc_function(data, len) == received_crc \
 )
 
+/**
+ * @brief Incremental CRC-8: `ul_crc_crc8_final(ul_crc_crc8_update(ul_crc_crc8_init(), data, len))`
+ * is equal to `ul_crc_crc8(data, len)`, also when `data` is fed in more chunks (e.g. byte by byte on UART receive).
+ */
+#define ul_crc_crc8_init()( \
+	(uint8_t) UL_CONFIG_CRC8_INITIAL_VALUE \
+)
+
+#define ul_crc_crc8_final(crc)( \
+	(uint8_t) ((crc) ^ UL_CONFIG_CRC_CRC8_FINAL_XOR_VALUE) \
+)
+
+#ifdef UL_CONFIG_CRC_CRC16_POLYNOMIAL
+/**
+ * @brief Incremental CRC-16, as the CRC-8 one.
+ */
+#define ul_crc_crc16_init()( \
+	(uint16_t) UL_CONFIG_CRC_CRC16_INITIAL_VALUE \
+)
+
+#define ul_crc_crc16_final(crc)( \
+	(uint16_t) ((crc) ^ UL_CONFIG_CRC_CRC16_FINAL_XOR_VALUE) \
+)
+#endif
+
+#ifdef UL_CONFIG_CRC_CRC32_POLYNOMIAL
+/**
+ * @brief Incremental CRC-32, as the CRC-8 one.
+ */
+#define ul_crc_crc32_init()( \
+	(uint32_t) UL_CONFIG_CRC_CRC32_INITIAL_VALUE \
+)
+
+#define ul_crc_crc32_final(crc)( \
+	(uint32_t) ((crc) ^ UL_CONFIG_CRC_CRC32_FINAL_XOR_VALUE) \
+)
+#endif
+
 /************************************************************************************************************
 * Public Types Definitions
 ************************************************************************************************************/
@@ -62,4 +100,39 @@
  */
 extern uint8_t ul_crc_crc8(const uint8_t *data, uint32_t len);
 
+/**
+ * @brief Fold a buffer into a running CRC-8.
+ * @param crc The running CRC-8: `ul_crc_crc8_init()` or the value returned by the previous call.
+ * @param data The data buffer.
+ * @param len `sizeof(data)`.
+ * @return The updated running CRC-8; finalize it with `ul_crc_crc8_final()`.
+ */
+extern uint8_t ul_crc_crc8_update(uint8_t crc, const uint8_t *data, uint32_t len);
+
+#ifdef UL_CONFIG_CRC_CRC16_POLYNOMIAL
+/**
+ * @brief Compute the CRC-16 of a buffer.
+ * @note You can found the CRC-16 configurations on the `ul_configs.h` header.
+ */
+extern uint16_t ul_crc_crc16(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Fold a buffer into a running CRC-16 (see `ul_crc_crc8_update()`).
+ */
+extern uint16_t ul_crc_crc16_update(uint16_t crc, const uint8_t *data, uint32_t len);
+#endif
+
+#ifdef UL_CONFIG_CRC_CRC32_POLYNOMIAL
+/**
+ * @brief Compute the CRC-32 of a buffer.
+ * @note You can found the CRC-32 configurations on the `ul_configs.h` header.
+ */
+extern uint32_t ul_crc_crc32(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Fold a buffer into a running CRC-32 (see `ul_crc_crc8_update()`).
+ */
+extern uint32_t ul_crc_crc32_update(uint32_t crc, const uint8_t *data, uint32_t len);
+#endif
+
 #endif  /* INC_UL_CRC_H_ */
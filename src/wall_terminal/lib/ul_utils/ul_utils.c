@@ -30,10 +30,42 @@
 * Private Functions Prototypes
  ************************************************************************************************************/
 
+/**
+ * @brief Base 10 `itoa()`: it is not part of the C standard library (e.g. glibc), only of newlib and avr-libc,
+ * which also declare `__itoa()` in `stdlib.h`.
+ * @return `str`.
+ */
+static char* __ul_utils_itoa(int x, char *str);
+
 /************************************************************************************************************
 * Private Functions Definitions
  ************************************************************************************************************/
 
+char* __ul_utils_itoa(int x, char *str){
+	unsigned int n = (x < 0 ? -(unsigned int) x : (unsigned int) x);
+	uint8_t i = 0, j;
+	char c;
+
+	do {
+		str[i++] = '0' + (n % 10);
+		n /= 10;
+	} while(n > 0);
+
+	if(x < 0)
+		str[i++] = '-';
+
+	str[i] = '\0';
+
+	// Digits were written backwards.
+	for(j=0; j<i/2; j++){
+		c = str[j];
+		str[j] = str[i - j - 1];
+		str[i - j - 1] = c;
+	}
+
+	return str;
+}
+
 /************************************************************************************************************
 * Public Functions Definitions
  ************************************************************************************************************/
@@ -129,7 +161,7 @@ char* ul_utils_ftoa(float x, char *str, uint8_t afterpoint){
 	int ipart = (int) x;
 	float fpart = x - (float) ipart;
 
-	itoa(ipart, str, 10);
+	__ul_utils_itoa(ipart, str);
 	strcat(str, ".");
 
 	float multiplier = 1.0;
@@ -137,7 +169,7 @@ char* ul_utils_ftoa(float x, char *str, uint8_t afterpoint){
 		multiplier *= 10.0;
 
 	int fpart_int = (int) (fpart * multiplier);
-	itoa(fpart_int, str + strlen(str), 10);
+	__ul_utils_itoa(fpart_int, str + strlen(str));
 
 	return str;
 }
@@ -131,6 +131,16 @@ ul_bs_button_id_t button_read();
 void uart_rx_mode();
 void uart_tx_mode();
 
+/**
+ * @brief Check whether the trimmer was rotated or some button was pressed, and the lock time elapsed after the last button press.
+ */
+bool states_pending();
+
+/**
+ * @brief Raise my pending bit on the "any news?" broadcast: reply with my ID in my time slot.
+ */
+void send_news();
+
 /**
  * @brief Send current button states and trimmer value to the control unit.
  * @note This function will reset all states after sending them.
@@ -273,36 +283,16 @@ bool send_task(){
 	if(uart_available()){
 		uint8_t b = uart_read_byte();
 
-		/**
-		 * If:
-		 * 	-	I read a master byte.
-		 * 	-	It's my turn on the bus.
-		 * 	-	The trimmer was rotated or:
-		 * 	-	Some button was pressed and...
-		 * 	-	...the lock time elapsed after the last button press.
-		 *
-		 * Then send the states and immediately reset them.
-		 */
-		if(
-			ul_ms_is_master_byte(b) &&
-			ul_ms_decode_master_byte(b) == ul_ms_decode_master_byte(CONFIG_RS485_DEVICE_ID) &&
-			(
-				#ifdef CONFIG_HW_TRIMMER
-					adc_is_changed
-				#endif
-
-				#if defined(CONFIG_HW_TRIMMER) && !defined(CONFIG_HW_NO_BTN)
-					||
-				#endif
-
-				#ifndef CONFIG_HW_NO_BTN
-					(
-						ul_bs_get_button_states() != 0 &&
-						millis() - last_button_press_ms >= CONFIG_TIME_BTN_LOCK_MS
-					)
-				#endif
-			)
-		){
+		// Not a master byte, or nothing to communicate.
+		if(!ul_ms_is_master_byte(b) || !states_pending())
+			return true;
+
+		// "Any news?" broadcast: the states are kept until I'm polled.
+		if(ul_ms_decode_master_byte(b) == CONFIG_RS485_BROADCAST_ID)
+			send_news();
+
+		// It's my turn on the bus: send the states and immediately reset them.
+		else if(ul_ms_decode_master_byte(b) == ul_ms_decode_master_byte(CONFIG_RS485_DEVICE_ID)){
 			send_states();
 
 			// States are now reset.
@@ -344,6 +334,37 @@ void uart_tx_mode(){
 	delayMicroseconds(CONFIG_UART_TX_MODE_DELAY_US);
 }
 
+bool states_pending(){
+	return (
+		#ifdef CONFIG_HW_TRIMMER
+			adc_is_changed
+		#endif
+
+		#if defined(CONFIG_HW_TRIMMER) && !defined(CONFIG_HW_NO_BTN)
+			||
+		#endif
+
+		#ifndef CONFIG_HW_NO_BTN
+			(
+				ul_bs_get_button_states() != 0 &&
+				millis() - last_button_press_ms >= CONFIG_TIME_BTN_LOCK_MS
+			)
+		#endif
+	);
+}
+
+void send_news(){
+
+	// Slot 0 starts right after the broadcast byte.
+	#if CONFIG_RS485_DEVICE_ID > 0
+	delayMicroseconds(CONFIG_RS485_DEVICE_ID * CONFIG_RS485_SLOT_US);
+	#endif
+
+	uart_tx_mode();
+	uart_write_byte(ul_ms_encode_slave_byte(CONFIG_RS485_DEVICE_ID));
+	uart_rx_mode();
+}
+
 void send_states(){
 	uart_tx_mode();
 